@@ -0,0 +1,66 @@
+/* ************************************************************************
+ *
+ *   host simulator: EEPROM
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+#ifndef SIM_AVR_EEPROM_H
+#define SIM_AVR_EEPROM_H
+
+#include <stddef.h>
+#include "../sim.h"
+
+/*
+ *  HINTs:
+ *  - EEMEM variables are initialized constants in host memory
+ *  - writes go to an overlay managed by the simulator
+ */
+
+#define EEMEM
+
+static inline uint8_t eeprom_read_byte(const uint8_t *Addr)
+{
+  return Sim_EE_Read(Addr);
+}
+
+static inline uint16_t eeprom_read_word(const uint16_t *Addr)
+{
+  const uint8_t     *Byte = (const uint8_t *)Addr;
+
+  return Sim_EE_Read(Byte) | (Sim_EE_Read(Byte + 1) << 8);
+}
+
+static inline void eeprom_read_block(void *Dst, const void *Src, size_t Size)
+{
+  uint8_t           *Dst8 = Dst;
+  const uint8_t     *Src8 = Src;
+
+  while (Size--) *Dst8++ = Sim_EE_Read(Src8++);
+}
+
+static inline void eeprom_write_byte(uint8_t *Addr, uint8_t Value)
+{
+  Sim_EE_Write(Addr, Value);
+}
+
+static inline void eeprom_write_word(uint16_t *Addr, uint16_t Value)
+{
+  Sim_EE_Write((uint8_t *)Addr, Value & 0xFF);
+  Sim_EE_Write((uint8_t *)Addr + 1, Value >> 8);
+}
+
+static inline void eeprom_write_block(const void *Src, void *Dst, size_t Size)
+{
+  const uint8_t     *Src8 = Src;
+  uint8_t           *Dst8 = Dst;
+
+  while (Size--) Sim_EE_Write(Dst8++, *Src8++);
+}
+
+#define eeprom_update_byte       eeprom_write_byte
+#define eeprom_update_word       eeprom_write_word
+#define eeprom_update_block      eeprom_write_block
+
+#endif
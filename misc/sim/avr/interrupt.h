@@ -0,0 +1,25 @@
+/* ************************************************************************
+ *
+ *   host simulator: interrupts
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+#ifndef SIM_AVR_INTERRUPT_H
+#define SIM_AVR_INTERRUPT_H
+
+#include "io.h"
+
+/* global interrupt flag */
+#define sei()                (SREG |= (1 << SREG_I))
+#define cli()                (SREG &= ~(1 << SREG_I))
+
+/* ISRs are plain functions called by the simulator */
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+#define ISR(Vector, ...)     void Vector(void); void Vector(void)
+#define reti()               return
+
+#endif
@@ -0,0 +1,430 @@
+/* ************************************************************************
+ *
+ *   host simulator: ATmega 328 I/O registers
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+#ifndef SIM_AVR_IO_H
+#define SIM_AVR_IO_H
+
+#include "../sim.h"
+
+
+/*
+ *  register access
+ *  - data space addresses of the ATmega 328
+ */
+
+#define _SFR_MEM8(Addr)     (*Sim_Reg(Addr))
+#define _SFR_MEM16(Addr)    (*(volatile uint16_t *)Sim_Reg(Addr))
+#define _BV(Bit)            (1 << (Bit))
+
+
+/* ports */
+#define PINB        _SFR_MEM8(0x23)
+#define DDRB        _SFR_MEM8(0x24)
+#define PORTB       _SFR_MEM8(0x25)
+#define PINC        _SFR_MEM8(0x26)
+#define DDRC        _SFR_MEM8(0x27)
+#define PORTC       _SFR_MEM8(0x28)
+#define PIND        _SFR_MEM8(0x29)
+#define DDRD        _SFR_MEM8(0x2A)
+#define PORTD       _SFR_MEM8(0x2B)
+
+/* interrupt flags */
+#define TIFR0       _SFR_MEM8(0x35)
+#define TIFR1       _SFR_MEM8(0x36)
+#define TIFR2       _SFR_MEM8(0x37)
+#define PCIFR       _SFR_MEM8(0x3B)
+#define EIFR        _SFR_MEM8(0x3C)
+#define EIMSK       _SFR_MEM8(0x3D)
+#define GPIOR0      _SFR_MEM8(0x3E)
+#define EECR        _SFR_MEM8(0x3F)
+#define EEDR        _SFR_MEM8(0x40)
+#define EEAR        _SFR_MEM16(0x41)
+#define GTCCR       _SFR_MEM8(0x43)
+
+/* Timer0 */
+#define TCCR0A      _SFR_MEM8(0x44)
+#define TCCR0B      _SFR_MEM8(0x45)
+#define TCNT0       _SFR_MEM8(0x46)
+#define OCR0A       _SFR_MEM8(0x47)
+#define OCR0B       _SFR_MEM8(0x48)
+
+#define GPIOR1      _SFR_MEM8(0x4A)
+#define GPIOR2      _SFR_MEM8(0x4B)
+
+/* SPI */
+#define SPCR        _SFR_MEM8(0x4C)
+#define SPSR        _SFR_MEM8(0x4D)
+#define SPDR        _SFR_MEM8(0x4E)
+
+/* analog comparator and core */
+#define ACSR        _SFR_MEM8(0x50)
+#define SMCR        _SFR_MEM8(0x53)
+#define MCUSR       _SFR_MEM8(0x54)
+#define MCUCR       _SFR_MEM8(0x55)
+#define SREG        _SFR_MEM8(0x5F)
+#define WDTCSR      _SFR_MEM8(0x60)
+#define CLKPR       _SFR_MEM8(0x61)
+#define PRR         _SFR_MEM8(0x64)
+#define OSCCAL      _SFR_MEM8(0x66)
+#define PCICR       _SFR_MEM8(0x68)
+#define EICRA       _SFR_MEM8(0x69)
+#define PCMSK0      _SFR_MEM8(0x6B)
+#define PCMSK1      _SFR_MEM8(0x6C)
+#define PCMSK2      _SFR_MEM8(0x6D)
+#define TIMSK0      _SFR_MEM8(0x6E)
+#define TIMSK1      _SFR_MEM8(0x6F)
+#define TIMSK2      _SFR_MEM8(0x70)
+
+/* ADC */
+#define ADCW        _SFR_MEM16(0x78)
+#define ADC         _SFR_MEM16(0x78)
+#define ADCL        _SFR_MEM8(0x78)
+#define ADCH        _SFR_MEM8(0x79)
+#define ADCSRA      _SFR_MEM8(0x7A)
+#define ADCSRB      _SFR_MEM8(0x7B)
+#define ADMUX       _SFR_MEM8(0x7C)
+#define DIDR0       _SFR_MEM8(0x7E)
+#define DIDR1       _SFR_MEM8(0x7F)
+
+/* Timer1 */
+#define TCCR1A      _SFR_MEM8(0x80)
+#define TCCR1B      _SFR_MEM8(0x81)
+#define TCCR1C      _SFR_MEM8(0x82)
+#define TCNT1       _SFR_MEM16(0x84)
+#define ICR1        _SFR_MEM16(0x86)
+#define OCR1A       _SFR_MEM16(0x88)
+#define OCR1B       _SFR_MEM16(0x8A)
+
+/* Timer2 */
+#define TCCR2A      _SFR_MEM8(0xB0)
+#define TCCR2B      _SFR_MEM8(0xB1)
+#define TCNT2       _SFR_MEM8(0xB2)
+#define OCR2A       _SFR_MEM8(0xB3)
+#define OCR2B       _SFR_MEM8(0xB4)
+#define ASSR        _SFR_MEM8(0xB6)
+
+/* TWI */
+#define TWBR        _SFR_MEM8(0xB8)
+#define TWSR        _SFR_MEM8(0xB9)
+#define TWAR        _SFR_MEM8(0xBA)
+#define TWDR        _SFR_MEM8(0xBB)
+#define TWCR        _SFR_MEM8(0xBC)
+#define TWAMR       _SFR_MEM8(0xBD)
+
+/* USART0 */
+#define UCSR0A      _SFR_MEM8(0xC0)
+#define UCSR0B      _SFR_MEM8(0xC1)
+#define UCSR0C      _SFR_MEM8(0xC2)
+#define UBRR0       _SFR_MEM16(0xC4)
+#define UBRR0L      _SFR_MEM8(0xC4)
+#define UBRR0H      _SFR_MEM8(0xC5)
+#define UDR0        _SFR_MEM8(0xC6)
+
+
+/*
+ *  register bits
+ */
+
+/* port pins */
+#define PB0   0
+#define PB1   1
+#define PB2   2
+#define PB3   3
+#define PB4   4
+#define PB5   5
+#define PB6   6
+#define PB7   7
+#define PC0   0
+#define PC1   1
+#define PC2   2
+#define PC3   3
+#define PC4   4
+#define PC5   5
+#define PC6   6
+#define PD0   0
+#define PD1   1
+#define PD2   2
+#define PD3   3
+#define PD4   4
+#define PD5   5
+#define PD6   6
+#define PD7   7
+
+/* TIFR0 / TIMSK0 */
+#define TOV0    0
+#define OCF0A   1
+#define OCF0B   2
+#define TOIE0   0
+#define OCIE0A  1
+#define OCIE0B  2
+
+/* TIFR1 / TIMSK1 */
+#define TOV1    0
+#define OCF1A   1
+#define OCF1B   2
+#define ICF1    5
+#define TOIE1   0
+#define OCIE1A  1
+#define OCIE1B  2
+#define ICIE1   5
+
+/* TIFR2 / TIMSK2 */
+#define TOV2    0
+#define OCF2A   1
+#define OCF2B   2
+#define TOIE2   0
+#define OCIE2A  1
+#define OCIE2B  2
+
+/* PCIFR / PCICR / EIFR / EIMSK */
+#define PCIF0   0
+#define PCIF1   1
+#define PCIF2   2
+#define PCIE0   0
+#define PCIE1   1
+#define PCIE2   2
+#define INTF0   0
+#define INTF1   1
+#define INT0    0
+#define INT1    1
+#define ISC00   0
+#define ISC01   1
+#define ISC10   2
+#define ISC11   3
+
+/* GTCCR */
+#define PSRSYNC 0
+#define PSRASY  1
+#define TSM     7
+
+/* TCCR0A / TCCR0B */
+#define WGM00   0
+#define WGM01   1
+#define COM0B0  4
+#define COM0B1  5
+#define COM0A0  6
+#define COM0A1  7
+#define CS00    0
+#define CS01    1
+#define CS02    2
+#define WGM02   3
+#define FOC0B   6
+#define FOC0A   7
+
+/* TCCR1A / TCCR1B / TCCR1C */
+#define WGM10   0
+#define WGM11   1
+#define COM1B0  4
+#define COM1B1  5
+#define COM1A0  6
+#define COM1A1  7
+#define CS10    0
+#define CS11    1
+#define CS12    2
+#define WGM12   3
+#define WGM13   4
+#define ICES1   6
+#define ICNC1   7
+#define FOC1B   6
+#define FOC1A   7
+
+/* TCCR2A / TCCR2B / ASSR */
+#define WGM20   0
+#define WGM21   1
+#define COM2B0  4
+#define COM2B1  5
+#define COM2A0  6
+#define COM2A1  7
+#define CS20    0
+#define CS21    1
+#define CS22    2
+#define WGM22   3
+#define FOC2B   6
+#define FOC2A   7
+#define TCR2BUB 0
+#define TCR2AUB 1
+#define OCR2BUB 2
+#define OCR2AUB 3
+#define TCN2UB  4
+#define AS2     5
+#define EXCLK   6
+
+/* SPCR / SPSR */
+#define SPR0    0
+#define SPR1    1
+#define CPHA    2
+#define CPOL    3
+#define MSTR    4
+#define DORD    5
+#define SPE     6
+#define SPIE    7
+#define SPI2X   0
+#define WCOL    6
+#define SPIF    7
+
+/* ACSR */
+#define ACIS0   0
+#define ACIS1   1
+#define ACIC    2
+#define ACIE    3
+#define ACI     4
+#define ACO     5
+#define ACBG    6
+#define ACD     7
+
+/* SMCR / MCUSR / MCUCR */
+#define SE      0
+#define SM0     1
+#define SM1     2
+#define SM2     3
+#define PORF    0
+#define EXTRF   1
+#define BORF    2
+#define WDRF    3
+#define IVCE    0
+#define IVSEL   1
+#define PUD     4
+#define BODSE   5
+#define BODS    6
+
+/* SREG */
+#define SREG_C  0
+#define SREG_Z  1
+#define SREG_N  2
+#define SREG_V  3
+#define SREG_S  4
+#define SREG_H  5
+#define SREG_T  6
+#define SREG_I  7
+
+/* WDTCSR / CLKPR */
+#define WDP0    0
+#define WDP1    1
+#define WDP2    2
+#define WDE     3
+#define WDCE    4
+#define WDP3    5
+#define WDIE    6
+#define WDIF    7
+#define CLKPS0  0
+#define CLKPS1  1
+#define CLKPS2  2
+#define CLKPS3  3
+#define CLKPCE  7
+
+/* PRR */
+#define PRADC     0
+#define PRUSART0  1
+#define PRSPI     2
+#define PRTIM1    3
+#define PRTIM0    5
+#define PRTIM2    6
+#define PRTWI     7
+
+/* ADCSRA / ADCSRB / ADMUX / DIDR0 / DIDR1 */
+#define ADPS0   0
+#define ADPS1   1
+#define ADPS2   2
+#define ADIE    3
+#define ADIF    4
+#define ADATE   5
+#define ADSC    6
+#define ADEN    7
+#define ADTS0   0
+#define ADTS1   1
+#define ADTS2   2
+#define ACME    6
+#define MUX0    0
+#define MUX1    1
+#define MUX2    2
+#define MUX3    3
+#define ADLAR   5
+#define REFS0   6
+#define REFS1   7
+#define ADC0D   0
+#define ADC1D   1
+#define ADC2D   2
+#define ADC3D   3
+#define ADC4D   4
+#define ADC5D   5
+#define AIN0D   0
+#define AIN1D   1
+
+/* TWCR / TWSR */
+#define TWIE    0
+#define TWEN    2
+#define TWWC    3
+#define TWSTO   4
+#define TWSTA   5
+#define TWEA    6
+#define TWINT   7
+#define TWPS0   0
+#define TWPS1   1
+
+/* UCSR0A / UCSR0B / UCSR0C */
+#define MPCM0   0
+#define U2X0    1
+#define UPE0    2
+#define DOR0    3
+#define FE0     4
+#define UDRE0   5
+#define TXC0    6
+#define RXC0    7
+#define TXB80   0
+#define RXB80   1
+#define UCSZ02  2
+#define TXEN0   3
+#define RXEN0   4
+#define UDRIE0  5
+#define TXCIE0  6
+#define RXCIE0  7
+#define UCPOL0  0
+#define UCSZ00  1
+#define UCSZ01  2
+#define USBS0   3
+#define UPM00   4
+#define UPM01   5
+#define UMSEL00 6
+#define UMSEL01 7
+
+
+/*
+ *  interrupt vectors
+ *  - numbering as on the ATmega 328
+ */
+
+#define INT0_vect            __vector_1
+#define INT1_vect            __vector_2
+#define PCINT0_vect          __vector_3
+#define PCINT1_vect          __vector_4
+#define PCINT2_vect          __vector_5
+#define WDT_vect             __vector_6
+#define TIMER2_COMPA_vect    __vector_7
+#define TIMER2_COMPB_vect    __vector_8
+#define TIMER2_OVF_vect      __vector_9
+#define TIMER1_CAPT_vect     __vector_10
+#define TIMER1_COMPA_vect    __vector_11
+#define TIMER1_COMPB_vect    __vector_12
+#define TIMER1_OVF_vect      __vector_13
+#define TIMER0_COMPA_vect    __vector_14
+#define TIMER0_COMPB_vect    __vector_15
+#define TIMER0_OVF_vect      __vector_16
+#define SPI_STC_vect         __vector_17
+#define USART_RX_vect        __vector_18
+#define USART0_RX_vect       __vector_18
+#define USART_UDRE_vect      __vector_19
+#define USART_TX_vect        __vector_20
+#define ADC_vect             __vector_21
+#define EE_READY_vect        __vector_22
+#define ANALOG_COMP_vect     __vector_23
+#define TWI_vect             __vector_24
+#define SPM_READY_vect       __vector_25
+
+#define _VECTORS_SIZE        (26 * 4)
+
+#endif
@@ -0,0 +1,25 @@
+/* ************************************************************************
+ *
+ *   host simulator: program memory
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+#ifndef SIM_AVR_PGMSPACE_H
+#define SIM_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+/* flash data is plain host memory */
+#define PROGMEM
+#define PSTR(String)             (String)
+#define pgm_read_byte(Addr)      (*(const uint8_t *)(Addr))
+#define pgm_read_word(Addr)      (*(const uint16_t *)(Addr))
+#define pgm_read_dword(Addr)     (*(const uint32_t *)(Addr))
+#define memcpy_P                 memcpy
+#define strcpy_P                 strcpy
+#define strlen_P                 strlen
+
+#endif
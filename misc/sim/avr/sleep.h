@@ -0,0 +1,28 @@
+/* ************************************************************************
+ *
+ *   host simulator: sleep modes
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+#ifndef SIM_AVR_SLEEP_H
+#define SIM_AVR_SLEEP_H
+
+#include "io.h"
+
+/* modes (SMCR's SM bits) */
+#define SLEEP_MODE_IDLE          SIM_SLEEP_IDLE
+#define SLEEP_MODE_ADC           SIM_SLEEP_ADC
+#define SLEEP_MODE_PWR_DOWN      SIM_SLEEP_PWR_DOWN
+#define SLEEP_MODE_PWR_SAVE      SIM_SLEEP_PWR_SAVE
+#define SLEEP_MODE_STANDBY       SIM_SLEEP_STANDBY
+#define SLEEP_MODE_EXT_STANDBY   SIM_SLEEP_EXT_STANDBY
+
+#define set_sleep_mode(Mode)     (SMCR = (SMCR & ~((1 << SM2) | (1 << SM1) | (1 << SM0))) | (Mode))
+#define sleep_enable()           (SMCR |= (1 << SE))
+#define sleep_disable()          (SMCR &= ~(1 << SE))
+#define sleep_cpu()              Sim_Sleep()
+#define sleep_mode()             do { sleep_enable(); sleep_cpu(); sleep_disable(); } while (0)
+
+#endif
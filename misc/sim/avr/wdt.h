@@ -0,0 +1,30 @@
+/* ************************************************************************
+ *
+ *   host simulator: watchdog
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+#ifndef SIM_AVR_WDT_H
+#define SIM_AVR_WDT_H
+
+#include "io.h"
+
+/* timeouts: 16ms << n */
+#define WDTO_15MS      0
+#define WDTO_30MS      1
+#define WDTO_60MS      2
+#define WDTO_120MS     3
+#define WDTO_250MS     4
+#define WDTO_500MS     5
+#define WDTO_1S        6
+#define WDTO_2S        7
+#define WDTO_4S        8
+#define WDTO_8S        9
+
+#define wdt_enable(Timeout)      Sim_WDT(Timeout)
+#define wdt_disable()            Sim_WDT(SIM_WDT_OFF)
+#define wdt_reset()              Sim_WDT_Reset()
+
+#endif
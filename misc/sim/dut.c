@@ -0,0 +1,642 @@
+/* ************************************************************************
+ *
+ *   host simulator: device under test
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+/*
+ *  HINTs:
+ *  - The DUT is a small network of components between the test probes
+ *    #1-#3 (nodes 1-3). Nodes 4-8 are internal nodes.
+ *  - Each probe is driven by a Norton equivalent (ADC pin, Rl and Rh) and
+ *    has a stray capacitance to GND.
+ *  - Inductors have a parallel loss resistance of 10 * sqrt(L / C_stray)
+ *    to damp the ringing with the stray capacitance (Q ~ 10).
+ *  - Nodal analysis with Newton's method, backward Euler integration and
+ *    an adaptive step size based on the voltage change per step.
+ *  - Specification: components separated by ';', values with SI prefixes
+ *    (p, n, u, m, k, M, G):
+ *      R <a> <b> <R>
+ *      C <a> <b> <C> [ESR] [U_0]
+ *      L <a> <b> <L> [R_DC]
+ *      D <anode> <cathode> [I_S] [n] [BV]
+ *      Q npn|pnp <C> <B> <E> [hFE] [I_S]
+ *      M nmos|pmos <D> <G> <S> [V_th] [K] [C_GS]
+ */
+
+
+/*
+ *  include header files
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "sim.h"
+
+
+/*
+ *  local constants
+ */
+
+#define DUT_ELEMENTS     24        /* max. number of elements */
+
+/* element types */
+#define TYPE_R           1         /* resistor */
+#define TYPE_C           2         /* capacitor */
+#define TYPE_L           3         /* inductor */
+#define TYPE_D           4         /* diode */
+#define TYPE_Q           5         /* BJT */
+#define TYPE_M           6         /* MOSFET */
+
+/* physics and numerics */
+#define V_T              0.02585   /* thermal voltage at 300K */
+#define G_MIN            1e-12     /* conductance from each node to GND */
+#define EXP_MAX          40.0      /* linearize exp() beyond this */
+#define DT_MIN           1e-9      /* min. time step */
+#define DT_MAX           1e-3      /* max. time step */
+#define DT_EVENT         2e-8      /* resolution of event detection */
+#define DV_LOW           0.002     /* increase step size below */
+#define DV_HIGH          0.02      /* decrease step size above */
+#define NEWTON_MAX       60        /* max. Newton iterations */
+#define NEWTON_TOL       1e-7      /* convergence limit */
+#define NEWTON_LIMIT     0.5       /* max. voltage change per iteration */
+
+
+/* element */
+typedef struct
+{
+  uint8_t           Type;          /* element type */
+  int8_t            Sign;          /* +1: NPN/N-ch, -1: PNP/P-ch */
+  uint8_t           Node[3];       /* nodes */
+  double            P[3];          /* parameters */
+  double            State;         /* U_C or I_L at last time point */
+} Element_Type;
+
+
+/*
+ *  local variables
+ */
+
+Dut_Env_Type        Dut_Env =
+{
+  5.001,            /* Vcc */
+  1.100,            /* bandgap */
+  2.495,            /* external reference */
+  0,                /* battery */
+  680,              /* Rl */
+  470000,           /* Rh */
+  20,               /* pin resistance, low side */
+  22,               /* pin resistance, high side */
+  40e-12,           /* stray capacitance */
+  0.3,              /* ADC noise */
+  0,                /* mains hum */
+};
+
+static Element_Type Element[DUT_ELEMENTS];
+static uint8_t      Elements;
+static uint8_t      Nodes = DUT_PROBES;      /* nodes in use */
+static uint8_t      Linear = 1;              /* network is linear */
+static uint8_t      Internal = DUT_NODES;    /* next free internal node */
+static uint8_t      External = DUT_PROBES;   /* user nodes in use */
+
+static double       V[DUT_NODES];            /* node voltages */
+static double       V_Old[DUT_NODES];        /* at last time point */
+static double       Drive_G[DUT_PROBES];     /* probe drivers */
+static double       Drive_I[DUT_PROBES];
+static double       Time;                    /* time point of V */
+static double       Dt = DT_MIN;             /* current time step */
+static double       Step;                    /* step being solved */
+
+
+/* ************************************************************************
+ *   element models
+ * ************************************************************************ */
+
+/*
+ *  exp() linearized for large arguments
+ */
+
+static double Exp(double x)
+{
+  if (x > EXP_MAX) return exp(EXP_MAX) * (1 + x - EXP_MAX);
+  return exp(x);
+}
+
+
+/*
+ *  add currents leaving the nodes
+ */
+
+static void Currents(const double *U, double *I)
+{
+  Element_Type      *E;
+  uint8_t           n;
+  uint8_t           a, b, c;
+  double            u, i, Is;
+
+  for (n = 0; n < Nodes; n++)
+  {
+    I[n] = G_MIN * U[n];
+
+    if (n < DUT_PROBES)       /* probe drivers and stray capacitance */
+      I[n] += Drive_G[n] * U[n] - Drive_I[n] + Dut_Env.C_Stray / Step * (U[n] - V_Old[n]);
+  }
+
+  for (n = 0; n < Elements; n++)
+  {
+    E = &Element[n];
+    a = E->Node[0]; b = E->Node[1]; c = E->Node[2];
+
+    switch (E->Type)
+    {
+      case TYPE_R:
+        i = (U[a] - U[b]) / E->P[0];
+        I[a] += i; I[b] -= i;
+        break;
+
+      case TYPE_C:
+        i = E->P[0] / Step * ((U[a] - U[b]) - E->State);
+        I[a] += i; I[b] -= i;
+        break;
+
+      case TYPE_L:
+        i = E->State + Step / E->P[0] * (U[a] - U[b]) + (U[a] - U[b]) / E->P[2];
+        I[a] += i; I[b] -= i;
+        break;
+
+      case TYPE_D:
+        u = U[a] - U[b];
+        Is = E->P[0];
+        i = Is * (Exp(u / (E->P[1] * V_T)) - 1);
+        if (E->P[2] > 0)      /* reverse breakdown */
+          i -= Is * Exp((-u - E->P[2]) / (E->P[1] * V_T));
+        I[a] += i; I[b] -= i;
+        break;
+
+      case TYPE_Q:
+      {
+        /* Ebers-Moll transport model */
+        double      U_be, U_bc, F, R, I_c, I_b;
+
+        U_be = E->Sign * (U[b] - U[c]);
+        U_bc = E->Sign * (U[b] - U[a]);
+        Is = E->P[1];
+        F = Exp(U_be / V_T) - 1;
+        R = Exp(U_bc / V_T) - 1;
+        I_c = Is * (F - R) - Is / 3 * R;      /* reverse beta 3 */
+        I_b = Is / E->P[0] * F + Is / 3 * R;
+        I[a] += E->Sign * I_c;
+        I[b] += E->Sign * I_b;
+        I[c] -= E->Sign * (I_c + I_b);
+        break;
+      }
+
+      case TYPE_M:
+      {
+        /* square law, symmetric, smoothed threshold */
+        double      U_gs, U_ds, U_ov, I_d, Vt_n = 2 * V_T;
+        uint8_t     d = a, s = c;
+
+        if (E->Sign * (U[a] - U[c]) < 0) { d = c; s = a; }
+        U_gs = E->Sign * (U[b] - U[s]);
+        U_ds = E->Sign * (U[d] - U[s]);
+        u = (U_gs - E->P[0]) / Vt_n;
+        U_ov = (u > EXP_MAX) ? u * Vt_n : Vt_n * log1p(exp(u));
+        if (U_ds < U_ov)
+          I_d = E->P[1] * (U_ov - U_ds / 2) * U_ds;
+        else
+          I_d = E->P[1] / 2 * U_ov * U_ov;
+        I[d] += E->Sign * I_d;
+        I[s] -= E->Sign * I_d;
+
+        /* body diode: source to drain */
+        u = E->Sign * (U[c] - U[a]);
+        i = E->Sign * 1e-12 * (Exp(u / V_T) - 1);
+        I[c] += i; I[a] -= i;
+        break;
+      }
+    }
+  }
+}
+
+
+/* ************************************************************************
+ *   solver
+ * ************************************************************************ */
+
+/*
+ *  solve A * x = b (Gaussian elimination with partial pivoting)
+ */
+
+static void Solve(double A[DUT_NODES][DUT_NODES], double *b, uint8_t n)
+{
+  uint8_t           i, j, k, p;
+  double            f, t;
+
+  for (k = 0; k < n; k++)
+  {
+    p = k;
+    for (i = k + 1; i < n; i++)
+      if (fabs(A[i][k]) > fabs(A[p][k])) p = i;
+
+    if (p != k)
+    {
+      for (j = 0; j < n; j++) { t = A[k][j]; A[k][j] = A[p][j]; A[p][j] = t; }
+      t = b[k]; b[k] = b[p]; b[p] = t;
+    }
+
+    for (i = k + 1; i < n; i++)
+    {
+      f = A[i][k] / A[k][k];
+      for (j = k; j < n; j++) A[i][j] -= f * A[k][j];
+      b[i] -= f * b[k];
+    }
+  }
+
+  for (k = n; k-- > 0;)
+  {
+    for (j = k + 1; j < n; j++) b[k] -= A[k][j] * b[j];
+    b[k] /= A[k][k];
+  }
+}
+
+
+/*
+ *  solve time step (Newton's method)
+ *  - numerical Jacobian
+ */
+
+static void Newton(double Delta)
+{
+  double            J[DUT_NODES][DUT_NODES];
+  double            F[DUT_NODES], F2[DUT_NODES], U[DUT_NODES];
+  double            Max, h = 1e-6;
+  uint8_t           i, j, Run;
+
+  Step = Delta;
+
+  for (Run = 0; Run < NEWTON_MAX; Run++)
+  {
+    Currents(V, F);
+
+    for (j = 0; j < Nodes; j++)
+    {
+      memcpy(U, V, sizeof(U));
+      U[j] += h;
+      Currents(U, F2);
+      for (i = 0; i < Nodes; i++) J[i][j] = (F2[i] - F[i]) / h;
+    }
+
+    for (i = 0; i < Nodes; i++) F[i] = -F[i];
+    Solve(J, F, Nodes);
+
+    Max = 0;
+    for (i = 0; i < Nodes; i++)
+    {
+      if (F[i] > NEWTON_LIMIT) F[i] = NEWTON_LIMIT;
+      if (F[i] < -NEWTON_LIMIT) F[i] = -NEWTON_LIMIT;
+      V[i] += F[i];
+      if (fabs(F[i]) > Max) Max = fabs(F[i]);
+    }
+
+    if (Linear || (Max < NEWTON_TOL)) break;
+  }
+
+  Sim_Stats.Steps++;
+}
+
+
+/*
+ *  accept time step
+ */
+
+static void Commit(void)
+{
+  Element_Type      *E;
+  uint8_t           n;
+
+  for (n = 0; n < Elements; n++)
+  {
+    E = &Element[n];
+    if (E->Type == TYPE_C)
+      E->State = V[E->Node[0]] - V[E->Node[1]];
+    else if (E->Type == TYPE_L)
+      E->State += Step / E->P[0] * (V[E->Node[0]] - V[E->Node[1]]);
+  }
+
+  memcpy(V_Old, V, sizeof(V));
+  Time += Step;
+}
+
+
+/*
+ *  advance DUT to given time
+ *  - optional event function (e.g. comparator output)
+ *
+ *  requires:
+ *  - Target: time in s
+ *  - Event: event function or NULL
+ *
+ *  returns:
+ *  - time reached (earlier than Target on event)
+ */
+
+double Dut_Advance(double Target, int (*Event)(void))
+{
+  double            Delta, Max, d;
+  int               Start = 0;
+  uint8_t           n, Bisect = 0;
+
+  if (Event) Start = Event();
+
+  while (Time < Target - 1e-15)
+  {
+    Delta = (Dt < Target - Time) ? Dt : Target - Time;
+
+    memcpy(V, V_Old, sizeof(V));
+    Newton(Delta);
+
+    /* event within step: bisect */
+    if (Event && (Event() != Start))
+    {
+      if (Delta > DT_EVENT)
+      {
+        memcpy(V, V_Old, sizeof(V));
+        Dt = Delta / 2;
+        Bisect = 1;
+        continue;
+      }
+
+      Commit();
+      return Time;
+    }
+
+    /* step size control */
+    Max = 0;
+    for (n = 0; n < Nodes; n++)
+    {
+      d = fabs(V[n] - V_Old[n]);
+      if (d > Max) Max = d;
+    }
+
+    Commit();
+
+    if (Max > DV_HIGH) Dt = Delta / 2;
+    else if ((Max < DV_LOW) && ! Bisect && (Delta >= Dt)) Dt = Delta * 2;
+    if (Dt < DT_MIN) Dt = DT_MIN;
+    if (Dt > DT_MAX) Dt = DT_MAX;
+  }
+
+  return Time;
+}
+
+
+/*
+ *  set probe driver (Norton equivalent)
+ */
+
+void Dut_Drive(uint8_t Probe, double G, double I)
+{
+  if ((Drive_G[Probe] != G) || (Drive_I[Probe] != I))
+  {
+    Drive_G[Probe] = G;
+    Drive_I[Probe] = I;
+    Dt = DT_MIN;              /* restart with small steps */
+  }
+}
+
+
+/*
+ *  voltage of probe
+ */
+
+double Dut_Voltage(uint8_t Probe)
+{
+  return V[Probe];
+}
+
+
+/*
+ *  reset state
+ *  - capacitors charged to their initial voltage
+ */
+
+void Dut_Reset(void)
+{
+  uint8_t           n;
+
+  memset(V, 0, sizeof(V));
+  memset(V_Old, 0, sizeof(V_Old));
+  Time = 0;
+  Dt = DT_MIN;
+
+  for (n = 0; n < Elements; n++)
+  {
+    if (Element[n].Type == TYPE_C) Element[n].State = Element[n].P[2];
+    else Element[n].State = 0;
+  }
+}
+
+
+/* ************************************************************************
+ *   parser
+ * ************************************************************************ */
+
+/*
+ *  value with SI prefix
+ */
+
+static int Value(const char *Token, double *Result)
+{
+  char              *End;
+  double            x;
+
+  x = strtod(Token, &End);
+  if (End == Token) return 0;
+
+  switch (*End)
+  {
+    case 'p': x *= 1e-12; End++; break;
+    case 'n': x *= 1e-9; End++; break;
+    case 'u': x *= 1e-6; End++; break;
+    case 'm': x *= 1e-3; End++; break;
+    case 'k': x *= 1e3; End++; break;
+    case 'M': x *= 1e6; End++; break;
+    case 'G': x *= 1e9; End++; break;
+  }
+
+  *Result = x;
+  return 1;
+}
+
+
+/*
+ *  node number
+ */
+
+static int Node(const char *Token, uint8_t *Result)
+{
+  int               n = atoi(Token);
+
+  if ((n < 1) || (n > DUT_NODES)) return 0;
+  *Result = n - 1;
+  if (n > Nodes) Nodes = n;
+  if (n > External) External = n;
+  return 1;
+}
+
+
+/*
+ *  add element
+ */
+
+static Element_Type *Add(uint8_t Type)
+{
+  Element_Type      *E;
+
+  if (Elements >= DUT_ELEMENTS) return NULL;
+  E = &Element[Elements++];
+  memset(E, 0, sizeof(Element_Type));
+  E->Type = Type;
+  E->Sign = 1;
+  return E;
+}
+
+
+/*
+ *  internal node for series resistance
+ */
+
+static int Split(Element_Type *E, double R)
+{
+  Element_Type      *S;
+  uint8_t           New;
+
+  if (R <= 0) return 1;
+  if (Internal <= External) return 0;
+
+  New = --Internal;
+  if (New + 1 > Nodes) Nodes = New + 1;
+
+  S = Add(TYPE_R);
+  if (S == NULL) return 0;
+
+  S->Node[0] = E->Node[0];
+  S->Node[1] = New;
+  S->P[0] = R;
+  E->Node[0] = New;
+  return 1;
+}
+
+
+/*
+ *  parse DUT specification
+ *
+ *  returns:
+ *  - 1 on success
+ *  - 0 on error
+ */
+
+int Dut_Parse(const char *Spec)
+{
+  char              Buffer[256];
+  char              *Item, *Save, *Token[9];
+  uint8_t           Count;
+  Element_Type      *E;
+  double            x;
+  uint8_t           n, First;
+
+  strncpy(Buffer, Spec, sizeof(Buffer) - 1);
+  Buffer[sizeof(Buffer) - 1] = 0;
+
+  for (Item = strtok_r(Buffer, ";", &Save); Item; Item = strtok_r(NULL, ";", &Save))
+  {
+    Count = 0;
+    for (Token[0] = strtok(Item, " \t"); Token[Count] && Count < 8; Token[++Count] = strtok(NULL, " \t"));
+    if (Count == 0) continue;
+
+    switch (toupper(Token[0][0]))
+    {
+      case 'R':
+      case 'C':
+      case 'L':
+        if (Count < 4) return 0;
+        E = Add((toupper(Token[0][0]) == 'R') ? TYPE_R : (toupper(Token[0][0]) == 'C') ? TYPE_C : TYPE_L);
+        if (E == NULL) return 0;
+        if (! Node(Token[1], &E->Node[0]) || ! Node(Token[2], &E->Node[1])) return 0;
+        if (! Value(Token[3], &E->P[0]) || (E->P[0] <= 0)) return 0;
+        if (E->Type == TYPE_L) E->P[2] = 10 * sqrt(E->P[0] / Dut_Env.C_Stray);
+        if ((Count > 5) && (E->Type == TYPE_C) && ! Value(Token[5], &E->P[2])) return 0;
+        if (Count > 4)
+        {
+          if (! Value(Token[4], &x)) return 0;
+          if (! Split(E, x)) return 0;
+        }
+        break;
+
+      case 'D':
+        if (Count < 3) return 0;
+        E = Add(TYPE_D);
+        if (E == NULL) return 0;
+        if (! Node(Token[1], &E->Node[0]) || ! Node(Token[2], &E->Node[1])) return 0;
+        E->P[0] = 2.5e-9;               /* I_S (1N4148) */
+        E->P[1] = 1.8;                  /* emission coefficient */
+        for (n = 3; n < Count; n++)
+          if (! Value(Token[n], &E->P[n - 3])) return 0;
+        Linear = 0;
+        break;
+
+      case 'Q':
+      case 'M':
+        if (Count < 5) return 0;
+        E = Add((toupper(Token[0][0]) == 'Q') ? TYPE_Q : TYPE_M);
+        if (E == NULL) return 0;
+        First = tolower(Token[1][0]);
+        if (First == 'p') E->Sign = -1;
+        else if (First != 'n') return 0;
+        for (n = 0; n < 3; n++)
+          if (! Node(Token[2 + n], &E->Node[n])) return 0;
+
+        if (E->Type == TYPE_Q)
+        {
+          E->P[0] = 200;                /* hFE */
+          E->P[1] = 1e-14;              /* I_S */
+        }
+        else
+        {
+          E->P[0] = 2.0;                /* V_th */
+          E->P[1] = 0.5;                /* K in A/V^2 */
+          E->P[2] = 500e-12;            /* C_GS */
+        }
+        for (n = 5; n < Count; n++)
+          if (! Value(Token[n], &E->P[n - 5])) return 0;
+
+        if (E->Type == TYPE_M)
+        {
+          x = E->P[2];
+          E->P[2] = 0;
+          E = Add(TYPE_C);              /* gate capacitance */
+          if (E == NULL) return 0;
+          E->Node[0] = Element[Elements - 2].Node[1];
+          E->Node[1] = Element[Elements - 2].Node[2];
+          E->P[0] = x;
+        }
+        Linear = 0;
+        break;
+
+      default:
+        return 0;
+    }
+  }
+
+  if (Internal < External) return 0;    /* user nodes collide with internal */
+
+  Dut_Reset();
+  return 1;
+}
@@ -0,0 +1,555 @@
+/* ************************************************************************
+ *
+ *   host simulator: test harness
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+/*
+ *  HINTs:
+ *  - The firmware's main() is compiled as fw_main(). Some firmware
+ *    functions are wrapped by the linker (--wrap) to take control of
+ *    the probing cycle and to capture the display output.
+ *  - TestKey() returns a short key press immediately. A cycle ends when
+ *    the cycle control asks for a key press (CHECK_KEY_TWICE).
+ *  - The profile menu after power-on is skipped, profile #1 is loaded.
+ *  - Detection time is measured from the first DischargeProbes() call
+ *    to the display of the result (LCD_Clear()).
+ *
+ *  usage: sim [-c cycles] [-n noise] [-m hum] [-s seed] [-q] -d "DUT spec"
+ *         sim -f
+ *         sim -a
+ *  - -n sets the ADC noise (rms, in LSB)
+ *  - -m adds 50Hz mains hum at the ADC input (peak, in mV)
+ *  - -f checks GetFactor() against the reference tables of factor.h
+ *    (build with -DSW_FACTOR_SEGMENTS to check the segments)
+ *  - -a checks the async ADC sampling against ReadU()
+ *    (build with -DADC_ASYNC)
+ */
+
+
+/*
+ *  include header files
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "common.h"
+#include "sim.h"
+#include "factor.h"
+
+
+/*
+ *  local constants
+ */
+
+#define SCREEN_X         32        /* max. chars per line */
+#define SCREEN_Y         16        /* max. lines */
+
+#define FACTOR_LIMIT     50        /* max. error of GetFactor() (0.01%) */
+#define ASYNC_LIMIT      2         /* max. difference to ReadU() (mV) */
+
+
+/*
+ *  wrapped firmware functions
+ */
+
+extern int fw_main(void);
+extern uint8_t __real_TestKey(uint16_t Timeout, uint8_t Mode);
+extern void __real_DischargeProbes(void);
+extern void __real_LCD_Clear(void);
+extern void __real_LCD_ClearLine(uint8_t Line);
+extern void __real_LCD_Char(unsigned char Char);
+extern void __real_AdjustmentMenu(uint8_t Mode);
+
+
+/*
+ *  local variables
+ */
+
+static char         Screen[SCREEN_Y][SCREEN_X + 1];   /* display text */
+static uint32_t     Cycles;        /* cycles to run */
+static uint32_t     Cycle;         /* current cycle */
+static uint8_t      Quiet;         /* don't print display */
+static double       Start;         /* start of detection */
+static double       Detect;        /* time used for detection */
+static uint8_t      Probing;       /* detection in progress */
+static double       Host_Start;    /* host time at start */
+static double       Total;         /* sum of detection times */
+
+
+/* ************************************************************************
+ *   display capture
+ * ************************************************************************ */
+
+/*
+ *  clear display buffer
+ */
+
+static void Screen_Clear(uint8_t Line, uint8_t Pos)
+{
+  uint8_t           n;
+
+  for (n = 0; n < SCREEN_Y; n++)
+  {
+    if ((Line == 0) || (Line == n + 1))
+    {
+      if (Pos <= SCREEN_X)
+      {
+        memset(&Screen[n][Pos - 1], ' ', SCREEN_X - Pos + 1);
+        Screen[n][SCREEN_X] = 0;
+      }
+    }
+  }
+}
+
+
+/*
+ *  clear display
+ *  - ends detection
+ */
+
+void __wrap_LCD_Clear(void)
+{
+  if (Probing)
+  {
+    Detect = Sim_Time() - Start;
+    Probing = 0;
+  }
+
+  Screen_Clear(0, 1);
+  __real_LCD_Clear();
+}
+
+
+/*
+ *  clear line
+ */
+
+void __wrap_LCD_ClearLine(uint8_t Line)
+{
+  if (Line == 0) Screen_Clear(UI.CharPos_Y, UI.CharPos_X);
+  else Screen_Clear(Line, 1);
+
+  __real_LCD_ClearLine(Line);
+}
+
+
+/*
+ *  display character
+ */
+
+void __wrap_LCD_Char(unsigned char Char)
+{
+  static const char Special[] = " ><COu[]123x[[]]";   /* LCD_CHAR_* */
+  uint8_t           x = UI.CharPos_X;
+  uint8_t           y = UI.CharPos_Y;
+
+  if ((x >= 1) && (x <= SCREEN_X) && (y >= 1) && (y <= SCREEN_Y))
+    Screen[y - 1][x - 1] = (Char < 16) ? Special[Char] : Char;
+
+  __real_LCD_Char(Char);
+}
+
+
+/*
+ *  print display text
+ */
+
+static void Screen_Print(void)
+{
+  uint8_t           n;
+  int               i;
+
+  for (n = 0; n < SCREEN_Y; n++)
+  {
+    for (i = SCREEN_X - 1; (i >= 0) && (Screen[n][i] == ' '); i--);
+    if (i >= 0) printf("  | %.*s\n", i + 1, Screen[n]);
+  }
+}
+
+
+/* ************************************************************************
+ *   probing cycle
+ * ************************************************************************ */
+
+/*
+ *  host time in seconds
+ */
+
+static double Host_Time(void)
+{
+  struct timespec   Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return Now.tv_sec + Now.tv_nsec * 1e-9;
+}
+
+
+/*
+ *  discharge probes
+ *  - starts detection
+ */
+
+void __wrap_DischargeProbes(void)
+{
+  if (! Probing && (Detect == 0))
+  {
+    Start = Sim_Time();
+    Probing = 1;
+  }
+
+  __real_DischargeProbes();
+}
+
+
+/*
+ *  test key
+ *  - end of cycle when called by cycle control
+ */
+
+uint8_t __wrap_TestKey(uint16_t Timeout, uint8_t Mode)
+{
+  static Sim_Stats_Type  Last;
+  double            Host;
+
+  if (Mode & CHECK_KEY_TWICE)      /* cycle control */
+  {
+    if (Detect > 0)                /* probing cycle */
+    {
+      Cycle++;
+      Total += Detect;
+      printf("cycle %u: %.3f ms, %u conversions, %u accesses, %u steps\n",
+        Cycle, Detect * 1e3,
+        Sim_Stats.Conversions - Last.Conversions,
+        Sim_Stats.Accesses - Last.Accesses,
+        Sim_Stats.Steps - Last.Steps);
+      if (! Quiet) Screen_Print();
+      Last = Sim_Stats;
+      Detect = 0;
+    }
+
+    if (Cycle >= Cycles)
+    {
+      Host = Host_Time() - Host_Start;
+      printf("total: %u cycles, %.3f ms avg, %.3f s simulated, %.3f s host, %.1f Mcycles/s\n",
+        Cycle, Total * 1e3 / Cycle, Sim_Time(), Host,
+        (double)Sim_Stats.Cycles / Host / 1e6);
+      exit(0);
+    }
+  }
+
+  return KEY_SHORT;
+}
+
+
+/*
+ *  adjustment menu
+ *  - load profile #1 without asking
+ */
+
+void __wrap_AdjustmentMenu(uint8_t Mode)
+{
+  if (Mode & STORAGE_SHORT)        /* profile selection after power-on */
+    ManageAdjustmentStorage(STORAGE_LOAD, 1);
+  else
+    __real_AdjustmentMenu(Mode);
+}
+
+
+/*
+ *  USART output
+ */
+
+static void Serial_Out(uint8_t Byte)
+{
+  putchar(Byte);
+}
+
+
+/* ************************************************************************
+ *   GetFactor() accuracy
+ * ************************************************************************ */
+
+/*
+ *  interpolate reference table
+ *  - integer math of the table based GetFactor()
+ */
+
+static uint16_t Factor_Ref(uint16_t U, uint16_t Start, uint16_t Step,
+  const uint16_t *Table, uint8_t Num)
+{
+  uint16_t          Index, Diff;
+
+  Index = (U - Start) / Step;
+  Diff = Step - (U - Start) % Step;
+  if (Index > Num - 2) Index = Num - 2;
+
+  return ((Table[Index] - Table[Index + 1]) * Diff + Step / 2) / Step
+    + Table[Index + 1];
+}
+
+
+/*
+ *  check one table
+ *
+ *  returns:
+ *  - max. error (in 0.01%)
+ */
+
+static unsigned Factor_Check(const char *Name, uint8_t ID, uint16_t Start,
+  uint16_t Step, const uint16_t *Table, uint8_t Num)
+{
+  uint16_t          U, End;
+  int               Ref, Value, Diff;
+  int               Max = 0;
+  double            Rel, Max_Rel = 0;
+  uint16_t          U_Max = Start;
+
+  End = Start + (Num - 1) * Step;
+
+  for (U = Start; U < End; U++)
+  {
+    Ref = Factor_Ref(U, Start, Step, Table, Num);
+    Value = GetFactor(U, ID);
+    Diff = abs(Value - Ref);
+    Rel = (double)Diff / Ref;
+
+    if (Diff > Max) Max = Diff;
+    if (Rel > Max_Rel)
+    {
+      Max_Rel = Rel;
+      U_Max = U;
+    }
+  }
+
+  printf("%-10s %4u-%4u: max. error %3d (%.3f%% at %u)\n",
+    Name, Start, End - 1, Max, Max_Rel * 100, U_Max);
+
+  return (unsigned)(Max_Rel * 10000 + 0.5);
+}
+
+
+/*
+ *  check all tables
+ *
+ *  returns:
+ *  - 0 if within FACTOR_LIMIT
+ *  - 1 otherwise
+ */
+
+static int Factor_Test(void)
+{
+  static const uint16_t Small[] = {FACTOR_SMALL_CAP_REF};
+  static const uint16_t Large[] = {FACTOR_LARGE_CAP_REF};
+#ifdef SW_INDUCTOR
+  static const uint16_t Ind[] = {FACTOR_INDUCTOR_REF};
+#endif
+  unsigned          Max = 0, Err;
+
+  Err = Factor_Check("small cap", TABLE_SMALL_CAP, FACTOR_SMALL_CAP_START,
+    FACTOR_SMALL_CAP_REF_STEP, Small, FACTOR_SMALL_CAP_REF_NUM);
+  if (Err > Max) Max = Err;
+
+  Err = Factor_Check("large cap", TABLE_LARGE_CAP, FACTOR_LARGE_CAP_START,
+    FACTOR_LARGE_CAP_REF_STEP, Large, FACTOR_LARGE_CAP_REF_NUM);
+  if (Err > Max) Max = Err;
+
+#ifdef SW_INDUCTOR
+  Err = Factor_Check("inductor", TABLE_INDUCTOR, FACTOR_INDUCTOR_START,
+    FACTOR_INDUCTOR_REF_STEP, Ind, FACTOR_INDUCTOR_REF_NUM);
+  if (Err > Max) Max = Err;
+#endif
+
+  if (Max > FACTOR_LIMIT)
+  {
+    printf("FAIL: limit %.2f%%\n", FACTOR_LIMIT / 100.0);
+    return 1;
+  }
+
+  printf("PASS: limit %.2f%%\n", FACTOR_LIMIT / 100.0);
+  return 0;
+}
+
+
+#ifdef ADC_ASYNC
+
+/* ************************************************************************
+ *   async ADC sampling
+ * ************************************************************************ */
+
+/*
+ *  compare ADC_Start()/ADC_Poll()/ADC_Collect() with ReadU()
+ *  - DUT: 4.7k between probe-1 and probe-3, probe-3 at GND
+ *  - probe-1 pulled up via Rl (Vcc reference), via Rh (re-run with
+ *    bandgap reference) and pulled down directly
+ *  - simulated time advances with register accesses only, so the
+ *    polling loop runs wait10us() as work done while sampling
+ *
+ *  returns:
+ *  - 0 if within ASYNC_LIMIT
+ *  - 1 otherwise
+ */
+
+static int Async_Test(void)
+{
+  static const char *Name[3] = {"Rl", "Rh", "GND"};
+  uint8_t           n;
+  uint16_t          U_1, U_2;
+  unsigned          Polls;
+  int               Diff, Max = 0;
+
+  /* environment matching the firmware's defaults */
+  Dut_Parse("R 1 3 4k7");
+  Dut_Env.Vcc = UREF_VCC / 1000.0;
+  Dut_Env.R_Low = R_LOW;
+  Dut_Env.R_High = R_HIGH;
+  Sim_Init(F_CPU);
+
+  /* ADC setup of main() */
+  ADCSRA = (1 << ADEN) | ADC_CLOCK_DIV;
+  Cfg.Samples = ADC_SAMPLES;
+  Cfg.AutoScale = 1;
+  Cfg.Ref = 1;
+  Cfg.Vcc = UREF_VCC;
+  Cfg.Bandgap = ReadU(ADC_CHAN_BANDGAP);
+  sei();
+
+  UpdateProbes(PROBE_1, PROBE_3, PROBE_2);
+  ADC_PORT = 0;
+
+  for (n = 0; n < 3; n++)
+  {
+    /* set probes */
+    ADC_DDR = Probes.Pin_2;             /* pull down probe-3 directly */
+    if (n == 0)
+    {
+      R_PORT = Probes.Rl_1;             /* pull up probe-1 via Rl */
+      R_DDR = Probes.Rl_1;
+    }
+    else if (n == 1)
+    {
+      R_PORT = Probes.Rh_1;             /* pull up probe-1 via Rh */
+      R_DDR = Probes.Rh_1;
+    }
+    else
+    {
+      R_DDR = 0;
+      R_PORT = 0;
+      ADC_DDR = Probes.Pin_1 | Probes.Pin_2;  /* pull down both */
+    }
+    wait10ms();
+
+    /* blocking and async reading */
+    U_1 = ReadU(Probes.Ch_1);
+    ADC_Start(Probes.Ch_1);
+    Polls = 0;
+    while (ADC_Poll() == 0)
+    {
+      wait10us();
+      Polls++;
+    }
+    U_2 = ADC_Collect();
+
+    Diff = abs((int)U_2 - (int)U_1);
+    if (Diff > Max) Max = Diff;
+
+    printf("%-3s ReadU() %4u mV, ADC_Collect() %4u mV, %3u polls\n",
+      Name[n], U_1, U_2, Polls);
+  }
+
+  R_DDR = 0;
+  R_PORT = 0;
+  ADC_DDR = 0;
+
+  if (Max > ASYNC_LIMIT)
+  {
+    printf("FAIL: limit %d mV\n", ASYNC_LIMIT);
+    return 1;
+  }
+
+  printf("PASS: limit %d mV\n", ASYNC_LIMIT);
+  return 0;
+}
+
+#endif // ADC_ASYNC
+
+
+/* ************************************************************************
+ *   main
+ * ************************************************************************ */
+
+int main(int argc, char **argv)
+{
+  int               Opt;
+  uint8_t           DUT = 0;
+
+  Cycles = 1;
+
+  while ((Opt = getopt(argc, argv, "ac:d:fm:n:s:q")) != -1)
+  {
+    switch (Opt)
+    {
+#ifdef ADC_ASYNC
+      case 'a':
+        return Async_Test();
+#endif
+
+      case 'c':
+        Cycles = atoi(optarg);
+        break;
+
+      case 'd':
+        if (! Dut_Parse(optarg))
+        {
+          fprintf(stderr, "invalid DUT: %s\n", optarg);
+          return 1;
+        }
+        DUT = 1;
+        break;
+
+      case 'f':
+        return Factor_Test();
+
+      case 'm':
+        Dut_Env.Hum = atof(optarg) / 1000;
+        break;
+
+      case 'n':
+        Dut_Env.Noise = atof(optarg);
+        break;
+
+      case 's':
+        Sim_Seed(strtoull(optarg, NULL, 0));
+        break;
+
+      case 'q':
+        Quiet = 1;
+        break;
+
+      default:
+        fprintf(stderr, "usage: %s [-c cycles] [-n noise] [-m hum] [-s seed] [-q] -d \"DUT spec\" | -f | -a\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if (! DUT) fprintf(stderr, "no DUT, probing open circuit\n");
+  if (Cycles == 0) Cycles = 1;
+
+  /* environment matching the firmware's defaults */
+  Dut_Env.Vcc = UREF_VCC / 1000.0;
+  Dut_Env.R_Low = R_LOW;
+  Dut_Env.R_High = R_HIGH;
+
+  Sim_Init(F_CPU);
+  Sim_Serial = Serial_Out;
+  Screen_Clear(0, 1);
+  Host_Start = Host_Time();
+
+  return fw_main();
+}
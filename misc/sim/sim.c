@@ -0,0 +1,1205 @@
+/* ************************************************************************
+ *
+ *   host simulator: register file and peripherals
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+/*
+ *  HINTs:
+ *  - Simulated time is counted in MCU cycles. Instruction timing isn't
+ *    modelled. Each register access takes SIM_ACCESS_CYCLES, the wait
+ *    functions, ADC conversions, SPI transfers and sleep modes take their
+ *    real time. Busy loops without register accesses (e.g. the delayed
+ *    start in MeasureInductance()) take no time.
+ *  - When the firmware polls a register which doesn't change, the time is
+ *    advanced to the next peripheral event (busy waiting loops).
+ *  - The DUT is solved lazily, i.e. when a probe voltage is needed or the
+ *    probe drivers change. While the analog comparator is used as input
+ *    capture trigger for Timer1 the DUT is stepped with the clock.
+ *  - Supported: ports B/C/D, ADC, analog comparator, Timer0/1/2 (normal,
+ *    CTC and PWM modes counting up only), hardware SPI and USART TX,
+ *    sleep modes, watchdog and EEPROM.
+ */
+
+
+/*
+ *  include header files
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sim.h"
+
+
+/*
+ *  local constants
+ */
+
+/* data space addresses */
+#define A_PINB      0x23
+#define A_DDRB      0x24
+#define A_PORTB     0x25
+#define A_PINC      0x26
+#define A_DDRC      0x27
+#define A_PORTC     0x28
+#define A_PIND      0x29
+#define A_DDRD      0x2A
+#define A_PORTD     0x2B
+#define A_TIFR0     0x35
+#define A_TIFR1     0x36
+#define A_TIFR2     0x37
+#define A_TCCR0A    0x44
+#define A_TCCR0B    0x45
+#define A_TCNT0     0x46
+#define A_OCR0A     0x47
+#define A_OCR0B     0x48
+#define A_SPCR      0x4C
+#define A_SPSR      0x4D
+#define A_SPDR      0x4E
+#define A_ACSR      0x50
+#define A_SMCR      0x53
+#define A_MCUSR     0x54
+#define A_MCUCR     0x55
+#define A_SREG      0x5F
+#define A_TIMSK0    0x6E
+#define A_TIMSK1    0x6F
+#define A_TIMSK2    0x70
+#define A_ADCL      0x78
+#define A_ADCH      0x79
+#define A_ADCSRA    0x7A
+#define A_ADCSRB    0x7B
+#define A_ADMUX     0x7C
+#define A_TCCR1A    0x80
+#define A_TCCR1B    0x81
+#define A_TCNT1     0x84
+#define A_ICR1      0x86
+#define A_OCR1A     0x88
+#define A_OCR1B     0x8A
+#define A_TCCR2A    0xB0
+#define A_TCCR2B    0xB1
+#define A_TCNT2     0xB2
+#define A_OCR2A     0xB3
+#define A_OCR2B     0xB4
+#define A_UCSR0A    0xC0
+#define A_UCSR0B    0xC1
+#define A_UDR0      0xC6
+
+/* timing */
+#define SIM_ACCESS_CYCLES     2         /* MCU cycles per register access */
+#define SIM_IRQ_CYCLES        10        /* MCU cycles for ISR entry and exit */
+#define SIM_POLL_READS        4         /* identical reads to detect polling */
+#define SIM_POLL_MAX          1000      /* max. time skip in us */
+
+/* flag register tag (reserved bit) */
+#define TAG                   0b10000000
+
+/* pins */
+#define PIN_POWER             6         /* PD6: power control */
+#define PIN_BUTTON            7         /* PD7: test button */
+#define PIN_RX                0         /* PD0: RxD */
+
+/* ADC */
+#define ADC_REF_BITS          0b11000000
+#define ADC_REF_BANDGAP       0b11000000
+#define ADC_CHAN_BITS         0b00001111
+
+/* pull-up resistor */
+#define R_PULLUP              35000.0
+
+
+/* timer */
+typedef struct
+{
+  uint8_t           Wide;          /* 16 bit timer */
+  uint8_t           TCCRA;         /* register addresses */
+  uint8_t           TCCRB;
+  uint8_t           TCNT;
+  uint8_t           OCRA;
+  uint8_t           OCRB;
+  uint8_t           TIFR;
+  uint8_t           TIMSK;
+  uint8_t           Vector;        /* first vector (compare A) */
+  uint8_t           Flags;         /* interrupt flags */
+  uint32_t          Count;         /* counter at Base */
+  uint32_t          Prescaler;     /* clock prescaler (0: stopped) */
+  uint64_t          Base;          /* cycle of last update */
+} Timer_Type;
+
+
+/*
+ *  local variables
+ */
+
+uint8_t             Sim_IO[SIM_IO_SIZE];     /* register file */
+static uint8_t      Shadow[SIM_IO_SIZE];     /* register file as seen last */
+Sim_Stats_Type      Sim_Stats;               /* statistics */
+uint32_t            Sim_Freq;                /* MCU clock */
+uint8_t             Sim_Button;              /* test button pressed */
+void                (*Sim_Serial)(uint8_t Byte);   /* USART TX sink */
+
+static Timer_Type   Timer[3];
+
+/* access tracking */
+static uint8_t      Force;         /* forced write detection: 1 UDR0, 2 SPDR */
+static uint8_t      Written;       /* write since last access */
+static uint8_t      LastAddr;      /* last register accessed */
+static uint8_t      LastValue;     /* value presented */
+static uint8_t      Repeat;        /* identical reads */
+static uint32_t     IrqCount;      /* dispatched interrupts */
+static uint8_t      InIrq;         /* ISR running */
+
+/* ADC */
+static uint8_t      ADC_Busy;      /* conversion running */
+static uint8_t      ADC_First;     /* next conversion is the first one */
+static uint8_t      ADC_Flag;      /* ADIF */
+static uint16_t     ADC_Result;    /* result of running conversion */
+static uint64_t     ADC_Done;      /* end of conversion */
+
+/* analog comparator */
+static uint8_t      AC_Out;        /* ACO */
+static uint8_t      AC_Flag;       /* ACI */
+
+/* SPI */
+static uint8_t      SPI_Flag;      /* SPIF */
+static uint8_t      SPI_Busy;      /* transfer running */
+static uint64_t     SPI_Done;      /* end of transfer */
+
+/* watchdog */
+static uint8_t      WDT_On;
+static uint64_t     WDT_Last;      /* last reset */
+static uint64_t     WDT_Timeout;   /* timeout in cycles */
+
+/* EEPROM overlay */
+#define EE_SIZE     1024
+static struct
+{
+  const uint8_t     *Addr;
+  uint8_t           Value;
+} EE[EE_SIZE];
+static uint16_t     EE_Used;
+
+/* PRNG */
+static uint64_t     Seed = 0x2545F4914F6CDD1DULL;
+
+/* interrupt vectors */
+#define VECTOR(n)   extern void __vector_##n(void) __attribute__((weak))
+VECTOR(7); VECTOR(8); VECTOR(9); VECTOR(10); VECTOR(11); VECTOR(12);
+VECTOR(13); VECTOR(14); VECTOR(15); VECTOR(16); VECTOR(17); VECTOR(21);
+VECTOR(23);
+
+static void (* Vectors[26])(void);
+
+
+/* ************************************************************************
+ *   support functions
+ * ************************************************************************ */
+
+#define NOW         Sim_Stats.Cycles
+
+/*
+ *  seconds of simulated time
+ */
+
+double Sim_Time(void)
+{
+  return (double)NOW / Sim_Freq;
+}
+
+
+/*
+ *  stop simulation
+ */
+
+void Sim_Abort(const char *Reason)
+{
+  fprintf(stderr, "sim: %s at %.6f s\n", Reason, Sim_Time());
+  exit(2);
+}
+
+
+/*
+ *  gaussian noise (Box-Muller)
+ */
+
+static double Noise(void)
+{
+  double            U1, U2;
+
+  Seed ^= Seed >> 12; Seed ^= Seed << 25; Seed ^= Seed >> 27;
+  U1 = ((Seed * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+  Seed ^= Seed >> 12; Seed ^= Seed << 25; Seed ^= Seed >> 27;
+  U2 = ((Seed * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+
+  if (U1 < 1e-300) U1 = 1e-300;
+  return sqrt(-2 * log(U1)) * cos(2 * M_PI * U2);
+}
+
+
+/*
+ *  set seed of PRNG
+ */
+
+void Sim_Seed(uint64_t Value)
+{
+  if (Value) Seed = Value;
+}
+
+
+/*
+ *  set 16 bit register
+ */
+
+static void Set16(uint8_t Addr, uint16_t Value)
+{
+  Sim_IO[Addr] = Value & 0xFF;
+  Sim_IO[Addr + 1] = Value >> 8;
+}
+
+static uint16_t Get16(const uint8_t *Regs, uint8_t Addr)
+{
+  return Regs[Addr] | (Regs[Addr + 1] << 8);
+}
+
+
+/* ************************************************************************
+ *   analog stuff
+ * ************************************************************************ */
+
+/*
+ *  update probe drivers
+ *  - ADC pin, Rl and Rh for each probe
+ */
+
+static void Drive(void)
+{
+  uint8_t           n;
+  uint8_t           Mask;
+  double            G, I, R, V;
+  uint8_t           PullUp;
+
+  Dut_Advance(Sim_Time(), NULL);        /* catch up with old drivers */
+
+  PullUp = ! (Sim_IO[A_MCUCR] & (1 << 4));   /* PUD */
+
+  for (n = 0; n < DUT_PROBES; n++)
+  {
+    G = 0; I = 0;
+
+    /* ADC pin */
+    Mask = 1 << n;
+    if (Sim_IO[A_DDRC] & Mask)
+    {
+      V = (Sim_IO[A_PORTC] & Mask) ? Dut_Env.Vcc : 0;
+      R = (Sim_IO[A_PORTC] & Mask) ? Dut_Env.R_Pin_High : Dut_Env.R_Pin_Low;
+      G += 1 / R; I += V / R;
+    }
+    else if (PullUp && (Sim_IO[A_PORTC] & Mask))
+    {
+      G += 1 / R_PULLUP; I += Dut_Env.Vcc / R_PULLUP;
+    }
+
+    /* Rl (PB0/2/4) and Rh (PB1/3/5) */
+    for (Mask = 1 << (2 * n); Mask & (0b11 << (2 * n)); Mask <<= 1)
+    {
+      R = (Mask & 0b010101) ? Dut_Env.R_Low : Dut_Env.R_High;
+
+      if (Sim_IO[A_DDRB] & Mask)
+      {
+        V = (Sim_IO[A_PORTB] & Mask) ? Dut_Env.Vcc : 0;
+        R += (Sim_IO[A_PORTB] & Mask) ? Dut_Env.R_Pin_High : Dut_Env.R_Pin_Low;
+        G += 1 / R; I += V / R;
+      }
+      else if (PullUp && (Sim_IO[A_PORTB] & Mask))
+      {
+        R += R_PULLUP;
+        G += 1 / R; I += Dut_Env.Vcc / R;
+      }
+    }
+
+    Dut_Drive(n, G, I);
+  }
+}
+
+
+/*
+ *  voltage of ADC channel
+ */
+
+static double Channel(uint8_t Channel)
+{
+  switch (Channel)
+  {
+    case 0:                   /* TP1 */
+    case 1:                   /* TP2 */
+    case 2:                   /* TP3 */
+      Dut_Advance(Sim_Time(), NULL);
+      return Dut_Voltage(Channel);
+
+    case 4:                   /* TP_REF */
+      return Dut_Env.Ref25;
+
+    case 5:                   /* TP_BAT */
+      return Dut_Env.Battery;
+
+    case 0x0E:                /* bandgap */
+      return Dut_Env.Bandgap;
+  }
+
+  return 0;                   /* TP_ZENER, unused, GND */
+}
+
+
+/*
+ *  digital inputs of port B or C
+ *  - DUT is not advanced
+ */
+
+static uint8_t Pins(uint8_t Addr)
+{
+  uint8_t           Value;
+  uint8_t           DDR = Sim_IO[Addr + 1];
+  uint8_t           n;
+  double            U;
+
+  Value = Sim_IO[Addr + 2] & DDR;
+
+  for (n = 0; n < 6; n++)
+  {
+    if (DDR & (1 << n)) continue;
+
+    if (Addr == A_PINB)       /* Rl/Rh */
+      U = Dut_Voltage(n / 2);
+    else                      /* ADC pins */
+      U = (n < DUT_PROBES) ? Dut_Voltage(n) : Channel(n);
+
+    if (U > Dut_Env.Vcc / 2) Value |= 1 << n;
+  }
+
+  return Value;
+}
+
+
+/*
+ *  polled input changed
+ */
+
+static uint8_t      Poll_Addr;          /* polled input register */
+static uint8_t      Poll_Value;         /* last value read */
+
+static int Pins_Event(void)
+{
+  return Pins(Poll_Addr) != Poll_Value;
+}
+
+
+/*
+ *  analog comparator output
+ */
+
+static int Comparator(void)
+{
+  uint8_t           Control = Sim_IO[A_ACSR];
+  double            Pos, Neg;
+
+  if (Control & (1 << 7)) return 0;     /* ACD: disabled */
+
+  /* positive input: bandgap or AIN0 */
+  Pos = (Control & (1 << 6)) ? Dut_Env.Bandgap : 0;
+
+  /* negative input: ADC multiplexer or AIN1 */
+  if ((Sim_IO[A_ADCSRB] & (1 << 6)) && ! (Sim_IO[A_ADCSRA] & (1 << 7)))
+  {
+    uint8_t Chan = Sim_IO[A_ADMUX] & 0b00000111;
+
+    Neg = (Chan < DUT_PROBES) ? Dut_Voltage(Chan) : Channel(Chan);
+  }
+  else
+    Neg = Dut_Env.Vcc;
+
+  return Pos > Neg;
+}
+
+
+/* ************************************************************************
+ *   timers
+ * ************************************************************************ */
+
+/*
+ *  counter top value based on waveform generation mode
+ */
+
+static uint32_t Timer_Top(Timer_Type *T, const uint8_t *Regs)
+{
+  uint8_t           Mode;
+
+  if (T->Wide)
+  {
+    Mode = (Regs[T->TCCRA] & 0b11) | ((Regs[T->TCCRB] >> 1) & 0b1100);
+    switch (Mode)
+    {
+      case 1: case 5: return 0x00FF;
+      case 2: case 6: return 0x01FF;
+      case 3: case 7: return 0x03FF;
+      case 4: case 9: case 11: case 15: return Get16(Regs, T->OCRA);
+      case 8: case 10: case 12: case 14: return Get16(Regs, A_ICR1);
+    }
+    return 0xFFFF;
+  }
+
+  Mode = (Regs[T->TCCRA] & 0b11) | ((Regs[T->TCCRB] >> 1) & 0b100);
+  if ((Mode == 2) || (Mode == 5) || (Mode == 7)) return Regs[T->OCRA];
+  return 0xFF;
+}
+
+
+/*
+ *  compare value
+ */
+
+static uint32_t Timer_Compare(Timer_Type *T, const uint8_t *Regs, uint8_t Addr)
+{
+  if (T->Wide) return Get16(Regs, Addr);
+  return Regs[Addr];
+}
+
+
+/*
+ *  clock prescaler
+ */
+
+static uint32_t Timer_Prescaler(Timer_Type *T, const uint8_t *Regs)
+{
+  static const uint16_t Std[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+  static const uint16_t Async[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+  uint8_t           CS = Regs[T->TCCRB] & 0b111;
+
+  return (T == &Timer[2]) ? Async[CS] : Std[CS];
+}
+
+
+/*
+ *  ticks until the counter leaves Value
+ */
+
+static uint32_t Timer_Distance(uint32_t Count, uint32_t Value, uint32_t Period)
+{
+  if (Value >= Period) return 0xFFFFFFFF;     /* never reached */
+  return ((Value + Period - Count % Period) % Period) + 1;
+}
+
+
+/*
+ *  update counter and flags up to now
+ *  - uses register settings in Regs
+ */
+
+static void Timer_Update(Timer_Type *T, const uint8_t *Regs)
+{
+  uint32_t          Ticks, Top, Period;
+
+  if (T->Prescaler == 0) return;        /* stopped */
+
+  Ticks = (NOW - T->Base) / T->Prescaler;
+  if (Ticks == 0) return;
+
+  Top = Timer_Top(T, Regs);
+  Period = Top + 1;
+
+  if (Timer_Distance(T->Count, Timer_Compare(T, Regs, T->OCRA), Period) <= Ticks)
+    T->Flags |= 0b010;        /* OCFxA */
+  if (Timer_Distance(T->Count, Timer_Compare(T, Regs, T->OCRB), Period) <= Ticks)
+    T->Flags |= 0b100;        /* OCFxB */
+  if ((Top == (T->Wide ? 0xFFFFU : 0xFFU)) && (Timer_Distance(T->Count, Top, Period) <= Ticks))
+    T->Flags |= 0b001;        /* TOVx */
+
+  T->Count = (T->Count + Ticks) % Period;
+  T->Base += (uint64_t)Ticks * T->Prescaler;
+}
+
+
+/*
+ *  cycle of next flag event
+ */
+
+static uint64_t Timer_Next(Timer_Type *T)
+{
+  uint32_t          Top, Period, Ticks;
+
+  if (T->Prescaler == 0) return UINT64_MAX;
+
+  Top = Timer_Top(T, Sim_IO);
+  Period = Top + 1;
+
+  Ticks = Timer_Distance(T->Count, Timer_Compare(T, Sim_IO, T->OCRA), Period);
+  if (Timer_Distance(T->Count, Timer_Compare(T, Sim_IO, T->OCRB), Period) < Ticks)
+    Ticks = Timer_Distance(T->Count, Timer_Compare(T, Sim_IO, T->OCRB), Period);
+  if (Timer_Distance(T->Count, Top, Period) < Ticks)
+    Ticks = Timer_Distance(T->Count, Top, Period);
+
+  return T->Base + (uint64_t)Ticks * T->Prescaler;
+}
+
+
+/*
+ *  counter value for reading
+ */
+
+static void Timer_Read(Timer_Type *T)
+{
+  Timer_Update(T, Sim_IO);
+  if (T->Wide) Set16(T->TCNT, T->Count);
+  else Sim_IO[T->TCNT] = T->Count;
+}
+
+
+/*
+ *  timer registers have been written
+ *  - Shadow holds the former settings
+ */
+
+static void Timer_Write(Timer_Type *T)
+{
+  Timer_Update(T, Shadow);              /* run with former settings */
+
+  /* counter written */
+  if ((Sim_IO[T->TCNT] != Shadow[T->TCNT]) ||
+      (T->Wide && (Sim_IO[T->TCNT + 1] != Shadow[T->TCNT + 1])))
+    T->Count = T->Wide ? Get16(Sim_IO, T->TCNT) : Sim_IO[T->TCNT];
+
+  T->Prescaler = Timer_Prescaler(T, Sim_IO);
+  T->Base = NOW;
+}
+
+
+/* ************************************************************************
+ *   peripherals
+ * ************************************************************************ */
+
+/*
+ *  start ADC conversion
+ *  - sample and hold at start
+ */
+
+static void ADC_Start(void)
+{
+  static const uint8_t Div[8] = {2, 2, 4, 8, 16, 32, 64, 128};
+  uint8_t           Mux = Sim_IO[A_ADMUX];
+  double            U, Ref;
+  long              Value;
+
+  U = Channel(Mux & ADC_CHAN_BITS);
+  U += Dut_Env.Hum * sin(2 * M_PI * 50 * Sim_Time());
+  Ref = ((Mux & ADC_REF_BITS) == ADC_REF_BANDGAP) ? Dut_Env.Bandgap : Dut_Env.Vcc;
+
+  Value = (long)floor(U / Ref * 1024 + Dut_Env.Noise * Noise());
+  if (Value < 0) Value = 0;
+  if (Value > 1023) Value = 1023;
+
+  ADC_Result = Value;
+  ADC_Busy = 1;
+  ADC_Done = NOW + (ADC_First ? 25 : 13) * Div[Sim_IO[A_ADCSRA] & 0b111];
+  ADC_First = 0;
+  Sim_Stats.Conversions++;
+}
+
+
+/*
+ *  ADCSRA written
+ */
+
+static void ADC_Control(uint8_t Old, uint8_t New)
+{
+  if (New & (1 << 4)) ADC_Flag = 0;     /* ADIF: write 1 to clear */
+
+  if (! (New & (1 << 7)))               /* ADEN cleared */
+  {
+    ADC_Busy = 0;                       /* abort conversion */
+    ADC_First = 1;
+  }
+  else if (! (Old & (1 << 7)))          /* ADEN set */
+    ADC_First = 1;
+
+  if ((New & (1 << 7)) && (New & (1 << 6)) && ! ADC_Busy)
+    ADC_Start();                        /* ADSC */
+}
+
+
+/*
+ *  start SPI transfer
+ */
+
+static void SPI_Start(void)
+{
+  static const uint8_t Div[4] = {4, 16, 64, 128};
+  uint32_t          Cycles;
+
+  if (! (Sim_IO[A_SPCR] & (1 << 6))) return;     /* SPE */
+
+  Cycles = 8 * Div[Sim_IO[A_SPCR] & 0b11];
+  if (Sim_IO[A_SPSR] & 0b1) Cycles /= 2;         /* SPI2X */
+
+  SPI_Flag = 0;
+  SPI_Busy = 1;
+  SPI_Done = NOW + Cycles;
+}
+
+
+/*
+ *  process register writes since last access
+ */
+
+void Sim_Sync(void)
+{
+  uint16_t          Addr;
+  uint8_t           Old, New;
+  uint8_t           Ports = 0;
+  uint8_t           Timers = 0;
+
+  if ((Force == 0) && (memcmp(Sim_IO, Shadow, SIM_IO_SIZE) == 0))
+    return;
+
+  Written = 1;
+
+  for (Addr = 0; Addr < SIM_IO_SIZE; Addr++)
+  {
+    Old = Shadow[Addr];
+    New = Sim_IO[Addr];
+
+    if (Old == New)
+    {
+      /* write detection by access */
+      if ((Addr == A_UDR0) && (Force & 1)) ;
+      else if ((Addr == A_SPDR) && (Force & 2)) ;
+      else continue;
+    }
+
+    switch (Addr)
+    {
+      case A_DDRB: case A_PORTB: case A_DDRC: case A_PORTC: case A_MCUCR:
+        Ports = 1;
+        break;
+
+      case A_PINB: case A_PINC: case A_PIND:
+        Sim_IO[Addr] = Old;             /* toggling not supported */
+        break;
+
+      case A_PORTD: case A_DDRD:
+        /* power control: pin driven low */
+        if ((Sim_IO[A_DDRD] & (1 << PIN_POWER)) &&
+            (Shadow[A_PORTD] & (1 << PIN_POWER)) &&
+            ! (Sim_IO[A_PORTD] & (1 << PIN_POWER)))
+          Sim_Abort("powered off");
+        break;
+
+      case A_TIFR0: case A_TIFR1: case A_TIFR2:
+        Timer[Addr - A_TIFR0].Flags &= ~New;
+        Sim_IO[Addr] = Timer[Addr - A_TIFR0].Flags;
+        break;
+
+      case A_TCCR0A: case A_TCCR0B: case A_TCNT0: case A_OCR0A: case A_OCR0B:
+        Timers |= 0b001;
+        break;
+
+      case A_TCCR1A: case A_TCCR1B: case A_TCNT1: case A_TCNT1 + 1:
+      case A_OCR1A: case A_OCR1A + 1: case A_OCR1B: case A_OCR1B + 1:
+      case A_ICR1: case A_ICR1 + 1:
+        Timers |= 0b010;
+        break;
+
+      case A_TCCR2A: case A_TCCR2B: case A_TCNT2: case A_OCR2A: case A_OCR2B:
+        Timers |= 0b100;
+        break;
+
+      case A_ADCSRA:
+        ADC_Control(Old, New);
+        break;
+
+      case A_ACSR:
+        if (New & (1 << 4)) AC_Flag = 0;     /* ACI: write 1 to clear */
+        break;
+
+      case A_SPDR:
+        SPI_Start();
+        break;
+
+      case A_UDR0:
+        if ((Sim_IO[A_UCSR0B] & (1 << 3)) && Sim_Serial)   /* TXEN0 */
+          Sim_Serial(New);
+        break;
+    }
+  }
+
+  Force = 0;
+
+  /* timers: update with former settings */
+  if (Timers & 0b001) Timer_Write(&Timer[0]);
+  if (Timers & 0b010) Timer_Write(&Timer[1]);
+  if (Timers & 0b100) Timer_Write(&Timer[2]);
+
+  /* probes */
+  if (Ports) Drive();
+
+  memcpy(Shadow, Sim_IO, SIM_IO_SIZE);
+}
+
+
+/*
+ *  interrupt dispatcher
+ */
+
+static void Interrupts(void)
+{
+  uint8_t           n, Vector;
+  uint8_t           Pending;
+  Timer_Type        *T;
+
+  while ((Sim_IO[A_SREG] & (1 << 7)) && ! InIrq)
+  {
+    Vector = 0;
+
+    /* timers: Timer2 (7-9), Timer1 (10-13), Timer0 (14-16) */
+    for (n = 3; n > 0 && Vector == 0; n--)
+    {
+      T = &Timer[n - 1];
+      Timer_Update(T, Sim_IO);
+      Pending = T->Flags & Sim_IO[T->TIMSK];
+
+      if (Pending & 0b00100000) { Vector = 10; T->Flags &= ~0b00100000; }
+      else if (Pending & 0b010) { Vector = T->Vector; T->Flags &= ~0b010; }
+      else if (Pending & 0b100) { Vector = T->Vector + 1; T->Flags &= ~0b100; }
+      else if (Pending & 0b001) { Vector = T->Vector + 2; T->Flags &= ~0b001; }
+    }
+
+    /* SPI, ADC, analog comparator */
+    if (Vector == 0)
+    {
+      if (SPI_Flag && (Sim_IO[A_SPCR] & (1 << 7)))
+        { Vector = 17; SPI_Flag = 0; }
+      else if (ADC_Flag && (Sim_IO[A_ADCSRA] & (1 << 3)))
+        { Vector = 21; ADC_Flag = 0; }
+      else if (AC_Flag && (Sim_IO[A_ACSR] & (1 << 3)))
+        { Vector = 23; AC_Flag = 0; }
+    }
+
+    if (Vector == 0) break;             /* nothing pending */
+
+    /* run ISR with interrupts disabled */
+    IrqCount++;
+    Sim_IO[A_SREG] &= ~(1 << 7);
+    Shadow[A_SREG] = Sim_IO[A_SREG];
+    InIrq = 1;
+    NOW += SIM_IRQ_CYCLES;
+    if (Vectors[Vector]) Vectors[Vector]();
+    Sim_Sync();                         /* commit ISR's writes */
+    Written = 1;
+    InIrq = 0;
+    Sim_IO[A_SREG] |= (1 << 7);
+    Shadow[A_SREG] = Sim_IO[A_SREG];
+  }
+}
+
+
+/*
+ *  comparator edge
+ */
+
+static void Comparator_Edge(uint8_t Out)
+{
+  uint8_t           Control = Sim_IO[A_ACSR];
+  uint8_t           Mode = Control & 0b11;
+  uint8_t           Capture;
+
+  /* ACIS: toggle, falling or rising edge */
+  if ((Mode == 0) || ((Mode == 2) && ! Out) || ((Mode == 3) && Out))
+    AC_Flag = 1;
+
+  /* input capture: ACIC and ICES1 */
+  if ((Control & (1 << 2)) && Timer[1].Prescaler)
+  {
+    Capture = (Sim_IO[A_TCCR1B] & (1 << 6)) ? Out : ! Out;
+    if (Capture)
+    {
+      Timer_Update(&Timer[1], Sim_IO);
+      Set16(A_ICR1, Timer[1].Count);
+      Shadow[A_ICR1] = Sim_IO[A_ICR1];
+      Shadow[A_ICR1 + 1] = Sim_IO[A_ICR1 + 1];
+      Timer[1].Flags |= 0b00100000;     /* ICF1 */
+    }
+  }
+}
+
+
+/*
+ *  next peripheral event
+ */
+
+static uint64_t Next_Event(void)
+{
+  uint64_t          Next = UINT64_MAX;
+  uint64_t          Value;
+  uint8_t           n;
+
+  if (ADC_Busy) Next = ADC_Done;
+  if (SPI_Busy && (SPI_Done < Next)) Next = SPI_Done;
+
+  for (n = 0; n < 3; n++)
+  {
+    Value = Timer_Next(&Timer[n]);
+    if (Value < Next) Next = Value;
+  }
+
+  return Next;
+}
+
+
+/*
+ *  advance simulated time
+ *  - processes peripheral events and interrupts
+ */
+
+static void Run(uint64_t Until)
+{
+  uint64_t          Next;
+  double            Reached;
+  int               Out;
+  uint8_t           n;
+  uint8_t           Monitor;
+
+  while (NOW < Until)
+  {
+    Next = Next_Event();
+    if (Next > Until) Next = Until;
+    if (Next <= NOW) Next = NOW + 1;
+
+    /* comparator in use: step DUT with the clock */
+    Monitor = ! (Sim_IO[A_ACSR] & (1 << 7)) &&
+              (((Sim_IO[A_ACSR] & (1 << 2)) && Timer[1].Prescaler) ||
+               (Sim_IO[A_ACSR] & (1 << 3)));
+
+    if (Monitor)
+    {
+      Dut_Advance(Sim_Time(), NULL);
+      Out = Comparator();
+      Reached = Dut_Advance((double)Next / Sim_Freq, Comparator);
+      if (Comparator() != Out)          /* edge */
+      {
+        Next = (uint64_t)ceil(Reached * Sim_Freq);
+        if (Next <= NOW) Next = NOW + 1;
+        NOW = Next;
+        AC_Out = ! Out;
+        Comparator_Edge(AC_Out);
+        Interrupts();
+        continue;
+      }
+    }
+
+    NOW = Next;
+
+    /* ADC */
+    if (ADC_Busy && (ADC_Done <= NOW))
+    {
+      ADC_Busy = 0;
+      ADC_Flag = 1;
+      Set16(A_ADCL, ADC_Result);
+      Shadow[A_ADCL] = Sim_IO[A_ADCL];
+      Shadow[A_ADCH] = Sim_IO[A_ADCH];
+
+      /* auto trigger: free running mode */
+      if ((Sim_IO[A_ADCSRA] & (1 << 5)) && ((Sim_IO[A_ADCSRB] & 0b111) == 0))
+        ADC_Start();
+    }
+
+    /* SPI */
+    if (SPI_Busy && (SPI_Done <= NOW))
+    {
+      SPI_Busy = 0;
+      SPI_Flag = 1;
+    }
+
+    /* timers */
+    for (n = 0; n < 3; n++) Timer_Update(&Timer[n], Sim_IO);
+
+    /* watchdog */
+    if (WDT_On && (NOW - WDT_Last > WDT_Timeout))
+      Sim_Abort("watchdog timeout");
+
+    Interrupts();
+  }
+}
+
+
+/*
+ *  prepare register for reading
+ */
+
+static void Prepare(uint8_t Addr)
+{
+  uint8_t           Value;
+  uint8_t           n;
+
+  switch (Addr)
+  {
+    case A_PINB:
+    case A_PINC:
+      Dut_Advance(Sim_Time(), NULL);
+      Sim_IO[Addr] = Pins(Addr);
+      break;
+
+    case A_PIND:
+      Value = Sim_IO[A_PORTD] & Sim_IO[A_DDRD];
+      Value |= ~Sim_IO[A_DDRD] & (1 << PIN_RX);
+      if (! Sim_Button) Value |= ~Sim_IO[A_DDRD] & (1 << PIN_BUTTON);
+      Sim_IO[Addr] = Value;
+      break;
+
+    case A_TIFR0: case A_TIFR1: case A_TIFR2:
+      n = Addr - A_TIFR0;
+      Timer_Update(&Timer[n], Sim_IO);
+      Sim_IO[Addr] = Timer[n].Flags | TAG;
+      break;
+
+    case A_TCNT0: Timer_Read(&Timer[0]); break;
+    case A_TCNT1: Timer_Read(&Timer[1]); break;
+    case A_TCNT2: Timer_Read(&Timer[2]); break;
+
+    case A_ADCSRA:
+      Value = Sim_IO[Addr] & ~((1 << 6) | (1 << 4));
+      if (ADC_Busy) Value |= (1 << 6);
+      if (ADC_Flag) Value |= (1 << 4);
+      Sim_IO[Addr] = Value;
+      break;
+
+    case A_ACSR:
+      Value = Sim_IO[Addr] & ~((1 << 5) | (1 << 4));
+      Dut_Advance(Sim_Time(), NULL);
+      if (Comparator()) Value |= (1 << 5);
+      if (AC_Flag) Value |= (1 << 4);
+      Sim_IO[Addr] = Value;
+      break;
+
+    case A_SPSR:
+      Sim_IO[Addr] = (Sim_IO[Addr] & 0b1) | (SPI_Flag ? (1 << 7) : 0);
+      break;
+
+    case A_SPDR:
+      Force |= 2;
+      break;
+
+    case A_UCSR0A:
+      Sim_IO[Addr] |= (1 << 5) | (1 << 6);   /* UDRE0, TXC0 */
+      break;
+
+    case A_UDR0:
+      Force |= 1;
+      break;
+  }
+
+  /* 16 bit registers: both bytes */
+  Shadow[Addr] = Sim_IO[Addr];
+  if (Addr < SIM_IO_SIZE - 1) Shadow[Addr + 1] = Sim_IO[Addr + 1];
+}
+
+
+/* ************************************************************************
+ *   register access
+ * ************************************************************************ */
+
+/*
+ *  access register
+ *  - called for each read or write access
+ *
+ *  requires:
+ *  - Addr: data space address
+ *
+ *  returns:
+ *  - pointer to register
+ */
+
+volatile uint8_t *Sim_Reg(uint8_t Addr)
+{
+  Sim_Sync();                           /* commit former writes */
+  Sim_Stats.Accesses++;
+  Run(NOW + SIM_ACCESS_CYCLES);
+  Prepare(Addr);
+
+  /* busy waiting: skip time to next event */
+  if (! Written && (Addr == LastAddr) && (Sim_IO[Addr] == LastValue))
+  {
+    Repeat++;
+    if (Repeat >= SIM_POLL_READS)
+    {
+      uint64_t      Next = Next_Event();
+      uint64_t      Max = NOW + (uint64_t)SIM_POLL_MAX * Sim_Freq / 1000000;
+
+      if (Max < Next) Next = Max;
+
+      if ((Addr == A_PINB) || (Addr == A_PINC))
+      {
+        /* input pin: stop when the DUT changes the level */
+        Poll_Addr = Addr;
+        Poll_Value = Sim_IO[Addr];
+        Max = (uint64_t)ceil(Dut_Advance((double)Next / Sim_Freq, Pins_Event) * Sim_Freq);
+        if (Max < Next) Next = Max;
+      }
+
+      Run(Next);
+      Sim_Sync();
+      Prepare(Addr);
+      Repeat = 0;
+    }
+  }
+  else
+    Repeat = 0;
+
+  Written = 0;
+  LastAddr = Addr;
+  LastValue = Sim_IO[Addr];
+
+  return &Sim_IO[Addr];
+}
+
+
+/* ************************************************************************
+ *   MCU core
+ * ************************************************************************ */
+
+/*
+ *  busy waiting
+ */
+
+void Sim_Wait(uint32_t Cycles)
+{
+  Sim_Sync();
+  Run(NOW + Cycles);
+  Repeat = 0;
+}
+
+
+/*
+ *  enter sleep mode
+ *  - returns after an interrupt has been processed
+ */
+
+void Sim_Sleep(void)
+{
+  uint8_t           Mode;
+  uint32_t          Count;
+  uint64_t          Next, Max;
+
+  Sim_Sync();
+  if (! (Sim_IO[A_SMCR] & 0b1)) return;      /* SE not set */
+
+  Mode = Sim_IO[A_SMCR] & SIM_SLEEP_MASK;
+  if (Mode == SIM_SLEEP_PWR_DOWN)
+    Sim_Abort("powered down");
+
+  /* ADC noise reduction mode starts conversion */
+  if ((Mode == SIM_SLEEP_ADC) && (Sim_IO[A_ADCSRA] & (1 << 7)) && ! ADC_Busy)
+    ADC_Start();
+
+  Count = IrqCount;
+  while (Count == IrqCount)
+  {
+    if (! (Sim_IO[A_SREG] & (1 << 7)))
+      Sim_Abort("sleeping with interrupts disabled");
+
+    Next = Next_Event();
+    Max = NOW + (uint64_t)SIM_POLL_MAX * Sim_Freq / 1000000;
+    Run((Next < Max) ? Next : Max);
+  }
+
+  Repeat = 0;
+}
+
+
+/*
+ *  watchdog
+ */
+
+void Sim_WDT(uint8_t Timeout)
+{
+  Sim_Sync();
+  WDT_On = (Timeout != SIM_WDT_OFF);
+  WDT_Timeout = ((uint64_t)Sim_Freq * 16 / 1000) << Timeout;
+  WDT_Last = NOW;
+}
+
+void Sim_WDT_Reset(void)
+{
+  WDT_Last = NOW;
+}
+
+
+/*
+ *  EEPROM
+ *  - writes are kept in an overlay
+ */
+
+uint8_t Sim_EE_Read(const uint8_t *Addr)
+{
+  uint16_t          n;
+
+  for (n = 0; n < EE_Used; n++)
+  {
+    if (EE[n].Addr == Addr) return EE[n].Value;
+  }
+
+  return *Addr;
+}
+
+void Sim_EE_Write(uint8_t *Addr, uint8_t Value)
+{
+  uint16_t          n;
+
+  for (n = 0; n < EE_Used; n++)
+  {
+    if (EE[n].Addr == Addr) break;
+  }
+
+  if (n == EE_SIZE) Sim_Abort("EEPROM overlay full");
+  if (n == EE_Used) EE_Used++;
+
+  EE[n].Addr = Addr;
+  EE[n].Value = Value;
+  NOW += (uint64_t)Sim_Freq * 34 / 10000;     /* 3.4ms per byte */
+}
+
+
+/*
+ *  set up simulator
+ */
+
+void Sim_Init(uint32_t Freq)
+{
+  static const Timer_Type Init[3] =
+  {
+    {0, A_TCCR0A, A_TCCR0B, A_TCNT0, A_OCR0A, A_OCR0B, A_TIFR0, A_TIMSK0, 14},
+    {1, A_TCCR1A, A_TCCR1B, A_TCNT1, A_OCR1A, A_OCR1B, A_TIFR1, A_TIMSK1, 11},
+    {0, A_TCCR2A, A_TCCR2B, A_TCNT2, A_OCR2A, A_OCR2B, A_TIFR2, A_TIMSK2, 7},
+  };
+
+  Sim_Freq = Freq;
+  memset(&Sim_Stats, 0, sizeof(Sim_Stats));
+  memset(Sim_IO, 0, SIM_IO_SIZE);
+  memcpy(Timer, Init, sizeof(Timer));
+
+  Sim_IO[A_MCUSR] = 0b1;                /* PORF: power-on reset */
+  Sim_IO[A_UCSR0A] = (1 << 5);          /* UDRE0 */
+  memcpy(Shadow, Sim_IO, SIM_IO_SIZE);
+
+  ADC_First = 1;
+
+  Vectors[7] = __vector_7;   Vectors[8] = __vector_8;   Vectors[9] = __vector_9;
+  Vectors[10] = __vector_10; Vectors[11] = __vector_11; Vectors[12] = __vector_12;
+  Vectors[13] = __vector_13; Vectors[14] = __vector_14; Vectors[15] = __vector_15;
+  Vectors[16] = __vector_16; Vectors[17] = __vector_17; Vectors[21] = __vector_21;
+  Vectors[23] = __vector_23;
+
+  Dut_Reset();
+  Drive();
+}
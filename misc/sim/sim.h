@@ -0,0 +1,123 @@
+/* ************************************************************************
+ *
+ *   host simulator: register file, peripherals and DUT model
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+
+/* ************************************************************************
+ *   register file
+ * ************************************************************************ */
+
+/*
+ *  HINTs:
+ *  - The I/O registers live in a data space image at the same addresses
+ *    as on the ATmega 328. Every register access calls Sim_Reg() first,
+ *    which commits writes done since the previous access, advances the
+ *    simulated time and updates the register for reading.
+ *  - Writes are detected by comparing the image with a shadow copy.
+ *    Interrupt flag registers have their reserved bit #7 set while being
+ *    read, so that any write (also "write 1 to clear") is noticed.
+ */
+
+#define SIM_IO_SIZE      0x100     /* size of data space image */
+
+extern uint8_t           Sim_IO[SIM_IO_SIZE];
+
+extern volatile uint8_t *Sim_Reg(uint8_t Addr);
+extern void Sim_Sync(void);
+
+
+/* ************************************************************************
+ *   MCU core
+ * ************************************************************************ */
+
+/* sleep modes (SMCR's SM bits) */
+#define SIM_SLEEP_MASK          0b00001110
+#define SIM_SLEEP_IDLE          0b00000000
+#define SIM_SLEEP_ADC           0b00000010
+#define SIM_SLEEP_PWR_DOWN      0b00000100
+#define SIM_SLEEP_PWR_SAVE      0b00000110
+#define SIM_SLEEP_STANDBY       0b00001100
+#define SIM_SLEEP_EXT_STANDBY   0b00001110
+
+/* watchdog */
+#define SIM_WDT_OFF             0xFF
+
+extern void Sim_Wait(uint32_t Cycles);
+extern void Sim_Sleep(void);
+extern void Sim_WDT(uint8_t Timeout);
+extern void Sim_WDT_Reset(void);
+
+
+/* ************************************************************************
+ *   EEPROM
+ * ************************************************************************ */
+
+extern uint8_t Sim_EE_Read(const uint8_t *Addr);
+extern void Sim_EE_Write(uint8_t *Addr, uint8_t Value);
+
+
+/* ************************************************************************
+ *   statistics and control
+ * ************************************************************************ */
+
+typedef struct
+{
+  uint64_t          Cycles;        /* simulated MCU cycles */
+  uint32_t          Accesses;      /* register accesses */
+  uint32_t          Conversions;   /* ADC conversions */
+  uint32_t          Steps;         /* DUT solver steps */
+} Sim_Stats_Type;
+
+extern Sim_Stats_Type    Sim_Stats;
+extern uint32_t          Sim_Freq;      /* MCU clock in Hz */
+extern uint8_t           Sim_Button;    /* test button pressed */
+extern void              (*Sim_Serial)(uint8_t Byte);   /* USART TX sink */
+
+extern void Sim_Init(uint32_t Freq);
+extern void Sim_Seed(uint64_t Value);
+extern double Sim_Time(void);
+extern void Sim_Abort(const char *Reason);
+
+
+/* ************************************************************************
+ *   DUT model
+ * ************************************************************************ */
+
+/* nodes */
+#define DUT_PROBES       3         /* test probes #1-#3 */
+#define DUT_NODES        8         /* probes + internal nodes */
+
+/* supply and references */
+typedef struct
+{
+  double            Vcc;           /* supply voltage */
+  double            Bandgap;       /* internal bandgap reference */
+  double            Ref25;         /* external 2.5V reference (TP_REF) */
+  double            Battery;       /* battery voltage at TP_BAT */
+  double            R_Low;         /* Rl probe resistor */
+  double            R_High;        /* Rh probe resistor */
+  double            R_Pin_Low;     /* pin resistance when sinking */
+  double            R_Pin_High;    /* pin resistance when sourcing */
+  double            C_Stray;       /* stray capacitance of probe to GND */
+  double            Noise;         /* ADC noise (rms, in LSB) */
+  double            Hum;           /* 50Hz mains hum at ADC input (peak, V) */
+} Dut_Env_Type;
+
+extern Dut_Env_Type      Dut_Env;
+
+extern int Dut_Parse(const char *Spec);
+extern void Dut_Reset(void);
+extern void Dut_Drive(uint8_t Probe, double G, double I);
+extern double Dut_Advance(double Time, int (*Event)(void));
+extern double Dut_Voltage(uint8_t Probe);
+
+#endif
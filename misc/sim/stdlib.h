@@ -0,0 +1,44 @@
+/* ************************************************************************
+ *
+ *   host simulator: avr-libc extensions of stdlib.h
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+#ifndef SIM_STDLIB_H
+#define SIM_STDLIB_H
+
+#include_next <stdlib.h>
+
+
+/*
+ *  unsigned integer to string
+ */
+
+static inline char *ultoa(unsigned long Value, char *String, int Radix)
+{
+  char              Buffer[33];
+  char              *Ptr = &Buffer[32];
+  char              *Out = String;
+  unsigned          Digit;
+
+  *Ptr = 0;
+  do
+  {
+    Digit = Value % Radix;
+    *--Ptr = (Digit < 10) ? '0' + Digit : 'a' + Digit - 10;
+    Value /= Radix;
+  } while (Value);
+
+  while ((*Out++ = *Ptr++));
+  return String;
+}
+
+static inline char *utoa(unsigned int Value, char *String, int Radix)
+{
+  return ultoa(Value, String, Radix);
+}
+
+
+#endif /* SIM_STDLIB_H */
@@ -0,0 +1,17 @@
+/* ************************************************************************
+ *
+ *   host simulator: busy waiting
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+#ifndef SIM_UTIL_DELAY_H
+#define SIM_UTIL_DELAY_H
+
+#include "../sim.h"
+
+#define _delay_us(Time)     Sim_Wait((uint32_t)((Time) * (F_CPU / 1000000.0)))
+#define _delay_ms(Time)     Sim_Wait((uint32_t)((Time) * (F_CPU / 1000.0)))
+
+#endif
@@ -0,0 +1,64 @@
+/* ************************************************************************
+ *
+ *   host simulator: wait functions
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+/*
+ *  HINT:
+ *  - replaces wait.S, time is passed to the MCU model
+ */
+
+
+/*
+ *  include header files
+ */
+
+#include "sim.h"
+
+
+/*
+ *  local macros
+ */
+
+#define WAIT(Name, us) \
+  void wait##Name(void) { Sim_Wait((uint32_t)((uint64_t)(us) * Sim_Freq / 1000000)); }
+
+
+/*
+ *  wait functions
+ */
+
+WAIT(1s, 1000000)
+WAIT(500ms, 500000)
+WAIT(400ms, 400000)
+WAIT(300ms, 300000)
+WAIT(200ms, 200000)
+WAIT(100ms, 100000)
+WAIT(50ms, 50000)
+WAIT(40ms, 40000)
+WAIT(30ms, 30000)
+WAIT(20ms, 20000)
+WAIT(10ms, 10000)
+WAIT(5ms, 5000)
+WAIT(4ms, 4000)
+WAIT(3ms, 3000)
+WAIT(2ms, 2000)
+WAIT(1ms, 1000)
+WAIT(500us, 500)
+WAIT(400us, 400)
+WAIT(300us, 300)
+WAIT(200us, 200)
+WAIT(100us, 100)
+WAIT(50us, 50)
+WAIT(40us, 40)
+WAIT(30us, 30)
+WAIT(20us, 20)
+WAIT(10us, 10)
+WAIT(5us, 5)
+WAIT(4us, 4)
+WAIT(3us, 3)
+WAIT(2us, 2)
+WAIT(1us, 1)
@@ -21,51 +21,62 @@
  */
 
 
+/*
+ *  local variables
+ */
+
+#ifdef ADC_ASYNC
+/* interrupt-driven sampling run */
+volatile ADC_Run_Type  ADC_Run;      /* state of async run */
+#endif
+
+#ifdef ADC_STATE_CACHE
+/* state of ADC and voltage reference */
+ADC_State_Type         ADC_State;    /* cached ADC state */
+#endif
+
+#ifdef ADC_NOISE_REDUCTION
+uint8_t                ADC_Sleep = 0;     /* sleep mode for ReadU() */
+volatile uint8_t       ADC_Wakeup;        /* conversion done */
+#endif
+
+
+
 /* ************************************************************************
- *   ADC
+ *   ADC support
  * ************************************************************************ */
 
 /*
- *  read ADC channel and return voltage in mV
- *  - use Vcc as reference by default
- *  - switch to bandgap reference for low voltages (< 1.0V) to improve
- *    ADC resolution
- *  - with a 125kHz ADC clock a single conversion needs about 0.1ms
- *    with 25 samples we end up with about 2.6ms
+ *  select MUX input channel and voltage reference
+ *  - waits for the voltage at the AREF buffer cap to stabilize when
+ *    the reference source has changed
+ *  - runs a dummy conversion
  *
  *  requires:
- *  - Channel: ADC MUX input channel
- *    - ATmega328: register bits corresponding with MUX0-3
- *    - ATmega324/644/1284: register bits corresponding with MUX0-4
- *    - ATmega640/1280/2560: register bits corresponding with MUX0-4
- *      (TODO: add MUX5 to support also ADC8-15)
+ *  - Bits: ADMUX register bits (MUX channel and reference)
+ *
+ *  returns:
+ *  - register bits of voltage reference selected
  */
 
-uint16_t ReadU(uint8_t Channel)
+uint8_t ADC_SetMux(uint8_t Bits)
 {
-  uint16_t          U;             /* return value (mV) */
-  uint8_t           Counter;       /* loop counter */
   uint8_t           Ref;           /* voltage reference register bits */
-  uint32_t          Value;         /* ADC value */
 
-  /* AREF pin is connected to external buffer cap (1nF) */
+#ifdef ADC_STATE_CACHE
+  uint8_t           Dummy = 1;     /* flag for dummy conversion */
 
-#if 0
-  /* manage channels ADC8-15 (ATmega640/1280/2560) */
-  if (Channel & 0b00100000)        /* bit 6 set: ADC8-15 */
-    ADCSRB |= (1 << MUX5);         /* set MUX5 */
-  else                             /* bit 6 not set: ADC0-7 */
-    ADCSRB &= ~(1 << MUX5);        /* clear MUX5 */
-#endif
-
-  /* prepare bitfield for register: start with AVcc as voltage reference */
-  Channel &= ADC_CHAN_MASK;        /* filter reg bits for MUX channel */
-  Channel |= ADC_REF_VCC;          /* add bits for voltage reference: AVcc */
-//  toto LGT clear 2bit REFERENCIE REFS2!!!!
+  /*
+   *  ADC has converted this channel with this reference lately
+   *  - ADMUX is unchanged and no sleep/pause or ms-range wait since
+   *  - no need for a dummy conversion
+   */
 
-sample:
+  if ((ADC_State.Flags & ADC_STATE_VALID) && (ADMUX == Bits))
+    Dummy = 0;                     /* skip dummy conversion */
+#endif
 
-  ADMUX = Channel;                 /* set input channel and U reference */
+  ADMUX = Bits;                    /* set input channel and U reference */
 
   /*
    *  change of voltage reference
@@ -75,7 +86,7 @@ sample:
    *    ADC hasn't run for a while. So let's do one anyway.
    */
 
-  Ref = Channel & ADC_REF_MASK;    /* get register bits for voltage reference */
+  Ref = Bits & ADC_REF_MASK;       /* get register bits for voltage reference */
   if (Ref != Cfg.Ref)              /* reference source has changed */
   {
     /* wait some time for voltage stabilization */
@@ -96,9 +107,314 @@ sample:
     Cfg.Ref = Ref;                 /* update reference source */
   }
 
-  /* perform dummy conversion anyway */
-  ADCSRA |= (1 << ADSC);         /* start conversion */
-  while (ADCSRA & (1 << ADSC));  /* wait until conversion is done */
+  /* perform dummy conversion */
+#ifdef ADC_STATE_CACHE
+  if (Dummy)                       /* ADC state unknown */
+  {
+    ADC_Conversion();
+    ADC_State.Flags |= ADC_STATE_VALID;  /* ADC is up to date */
+  }
+#else
+  ADC_Conversion();
+#endif
+
+  return Ref;
+}
+
+
+#ifdef ADC_STATE_CACHE
+
+/*
+ *  get voltage reference to start with
+ *  - bandgap reference if the last reading of the channel was
+ *    low (sticky auto-scaling, prevents switching back and forth
+ *    between Vcc and bandgap for each reading)
+ *  - Vcc otherwise
+ *
+ *  requires:
+ *  - Channel: ADC MUX input channel (filtered)
+ *
+ *  returns:
+ *  - register bits of voltage reference
+ */
+
+uint8_t ADC_StartRef(uint8_t Channel)
+{
+  uint8_t           Ref = ADC_REF_VCC;  /* return value */
+
+  if ((Channel < 8) && (Cfg.AutoScale == 1))
+  {
+    if (ADC_State.LowMask & (1 << Channel))  /* low voltage lately */
+      Ref = ADC_REF_BANDGAP;
+  }
+
+  return Ref;
+}
+
+
+/*
+ *  update sticky auto-scaling after a reading
+ *
+ *  requires:
+ *  - Channel: ADC MUX input channel (filtered)
+ *  - Ref: register bits of voltage reference used
+ */
+
+void ADC_UpdateRef(uint8_t Channel, uint8_t Ref)
+{
+  uint8_t           Mask;          /* channel bit */
+
+  /* only for auto-scaled readings of ADC0-7 */
+  if ((Channel >= 8) || (Cfg.AutoScale != 1))
+    return;
+
+  Mask = 1 << Channel;
+
+  if (Ref == ADC_REF_BANDGAP)      /* low voltage */
+    ADC_State.LowMask |= Mask;       /* remember */
+  else                             /* high voltage */
+    ADC_State.LowMask &= ~Mask;      /* forget */
+}
+
+#endif // ADC_STATE_CACHE
+
+
+/*
+ *  run a single conversion and wait until it's done
+ *  - reading is left in ADCW
+ *  - uses ADC noise reduction sleep mode when selected by
+ *    ReadU_Sleep()
+ */
+
+void ADC_Conversion(void)
+{
+#ifdef ADC_NOISE_REDUCTION
+  if (ADC_Sleep)                   /* sleep mode selected */
+  {
+    ADC_SleepConversion();         /* sleep while converting */
+    return;
+  }
+#endif
+
+  ADCSRA |= (1 << ADSC);           /* start conversion */
+  while (ADCSRA & (1 << ADSC));    /* wait until conversion is done */
+}
+
+
+#ifdef ADC_NOISE_REDUCTION
+
+/*
+ *  run a single conversion in ADC noise reduction sleep mode
+ *  - CPU and I/O clocks are halted while the ADC converts, which
+ *    lowers the digital noise and the power consumption
+ *  - the ADC complete interrupt wakes up the MCU
+ *  - other interrupts might wake up the MCU too, so we go back to
+ *    sleep until the conversion is done
+ *  - falls back to busy waiting when interrupts are disabled
+ *  - ADC has to be enabled and idle, reading is left in ADCW
+ */
+
+void ADC_SleepConversion(void)
+{
+  if (! (SREG & (1 << SREG_I)))    /* interrupts disabled */
+  {
+    /* no way to wake up: busy waiting */
+    ADCSRA |= (1 << ADSC);         /* start conversion */
+    while (ADCSRA & (1 << ADSC));  /* wait until conversion is done */
+    return;
+  }
+
+  ADC_Wakeup = 0;                  /* reset flag */
+  ADCSRA |= (1 << ADIE);           /* enable ADC complete interrupt */
+  set_sleep_mode(SLEEP_MODE_ADC);  /* set sleep mode to "ADC noise reduction" */
+  sleep_enable();
+
+  /*
+   *  entering the sleep mode starts the conversion automatically
+   *  - disable interrupts for checking the flag to prevent a race
+   *  - sei() runs the next instruction before any pending interrupt,
+   *    so we can't miss the wake-up
+   */
+
+  while (1)
+  {
+    cli();                         /* disable interrupts */
+    if (ADC_Wakeup) break;         /* conversion is done */
+    sei();                         /* enable interrupts */
+    sleep_cpu();                   /* sleep (again) */
+  }
+
+  sei();                           /* enable interrupts */
+  sleep_disable();
+  ADCSRA &= ~(1 << ADIE);          /* disable ADC complete interrupt */
+}
+
+#endif // ADC_NOISE_REDUCTION
+
+
+#ifdef ADC_ADAPTIVE
+
+/*
+ *  check if sampling is stable enough for early termination
+ *  - standard error of mean: SE^2 = Var / n
+ *    with Var = (n * SumSq - Sum^2) / (n * (n - 1))
+ *  - sums are based on the difference to the first reading to keep
+ *    the numbers small
+ *  - compares with multiplications only, since a 32 bit division
+ *    per sample would eat most of the time saved
+ *  - Tolerance <= 16 and n <= 255 keep Tolerance^2 * n^2 * (n - 1)
+ *    within 32 bits
+ *
+ *  requires:
+ *  - Sum: sum of differences to first reading
+ *  - SumSq: sum of squared differences to first reading
+ *  - n: number of readings (>= 2)
+ *
+ *  returns:
+ *  - 1 if standard error is below Cfg.Tolerance
+ *  - 0 if not
+ */
+
+uint8_t ADC_Stable(int32_t Sum, uint32_t SumSq, uint8_t n)
+{
+  uint32_t          Var;           /* n^2 * (biased) variance */
+  uint32_t          Limit;         /* Tolerance^2 * n^2 * (n - 1) */
+
+  /* large spread: not stable anyway (also prevents overflow) */
+  if (SumSq > (UINT32_MAX / 256 / 256))
+    return 0;
+
+  /* n * SumSq - Sum^2 (can't be negative) */
+  Var = SumSq * n;
+  Var -= (uint32_t)(Sum * Sum);
+
+  /*
+   *  SE^2 <= Tolerance^2 in (1/16 ADC steps)^2
+   *  - Var * 256 / (n^2 * (n - 1)) <= Tolerance^2
+   *  - Var * 256 <= Tolerance^2 * n^2 * (n - 1)
+   */
+
+  Limit = (uint16_t)Cfg.Tolerance * Cfg.Tolerance;
+  Limit *= (uint16_t)n * n;
+  Limit *= n - 1;
+  Var <<= 8;                       /* * 256 */
+
+  if (Var <= Limit)
+    return 1;
+
+  return 0;
+}
+
+#endif // ADC_ADAPTIVE
+
+
+/*
+ *  convert sum of ADC readings to voltage in mV
+ *  - single sample: U = ADC reading * U_ref / 1024
+ *
+ *  requires:
+ *  - Value: sum of ADC readings
+ *  - Ref: register bits of voltage reference used
+ *  - Samples: number of readings summed up
+ *
+ *  returns:
+ *  - average voltage in mV
+ */
+
+uint16_t ADC_ScaleU(uint32_t Value, uint8_t Ref, uint8_t Samples)
+{
+  uint16_t          U;             /* voltage of reference */
+
+  /* get voltage of reference used */
+  if (Ref == ADC_REF_BANDGAP)      /* bandgap reference */
+    U = Cfg.Bandgap;                 /* voltage of bandgap reference */
+  else                             /* Vcc as reference */
+    U = Cfg.Vcc;                     /* voltage of Vcc */   
+
+  /* convert to voltage; */
+  Value *= U;                      /* ADC readings * U_ref */
+//  Value += 511 * Samples;          /* automagic rounding */
+  Value /= 1024;                   /* / 1024 for 10bit ADC */
+
+  /* de-sample to get average voltage */
+  Value /= Samples;
+
+  return (uint16_t)Value;
+}
+
+
+
+/* ************************************************************************
+ *   ADC
+ * ************************************************************************ */
+
+/*
+ *  read ADC channel and return voltage in mV
+ *  - use Vcc as reference by default
+ *  - switch to bandgap reference for low voltages (< 1.0V) to improve
+ *    ADC resolution
+ *  - with a 125kHz ADC clock a single conversion needs about 0.1ms
+ *    with 25 samples we end up with about 2.6ms
+ *
+ *  requires:
+ *  - Channel: ADC MUX input channel
+ *    - ATmega328: register bits corresponding with MUX0-3
+ *    - ATmega324/644/1284: register bits corresponding with MUX0-4
+ *    - ATmega640/1280/2560: register bits corresponding with MUX0-4
+ *      (TODO: add MUX5 to support also ADC8-15)
+ */
+
+uint16_t ReadU(uint8_t Channel)
+{
+  uint8_t           Counter;       /* loop counter */
+  uint8_t           Ref;           /* voltage reference register bits */
+  uint8_t           Scale;         /* auto-scaling flag */
+  uint16_t          Sample;        /* single ADC reading */
+  uint32_t          Value;         /* ADC value */
+#ifdef ADC_STATE_CACHE
+  uint8_t           Sticky = 0;    /* flag for sticky bandgap reference */
+#endif
+#ifdef ADC_ADAPTIVE
+  uint16_t          First = 0;     /* first ADC reading */
+  int16_t           Diff;          /* difference to first reading */
+  uint32_t          SumSq;         /* sum of squared differences */
+#endif
+
+  /* AREF pin is connected to external buffer cap (1nF) */
+
+#if 0
+  /* manage channels ADC8-15 (ATmega640/1280/2560) */
+  if (Channel & 0b00100000)        /* bit 6 set: ADC8-15 */
+    ADCSRB |= (1 << MUX5);         /* set MUX5 */
+  else                             /* bit 6 not set: ADC0-7 */
+    ADCSRB &= ~(1 << MUX5);        /* clear MUX5 */
+#endif
+
+#ifdef ADC_ASYNC
+  /* blocking reads and an async run can't share the ADC */
+  if (ADC_Run.Flags & ADC_RUN_BUSY)     /* async run pending */
+    ADC_Stop();                         /* abort it */
+#endif
+
+  Scale = Cfg.AutoScale;           /* auto-scaling */
+
+#ifdef ADC_STATE_CACHE
+  /* prepare bitfield for register: start with cached reference */
+  Channel &= ADC_CHAN_MASK;        /* filter reg bits for MUX channel */
+  Ref = ADC_StartRef(Channel);     /* get reference to start with */
+  if ((Ref == ADC_REF_BANDGAP) && (Scale == 1)) Sticky = 1;
+  Channel |= Ref;                  /* add bits for voltage reference */
+#else
+  /* prepare bitfield for register: start with AVcc as voltage reference */
+  Channel &= ADC_CHAN_MASK;        /* filter reg bits for MUX channel */
+  Channel |= ADC_REF_VCC;          /* add bits for voltage reference: AVcc */
+#endif
+//  toto LGT clear 2bit REFERENCIE REFS2!!!!
+
+sample:
+
+  /* set channel and reference, and perform dummy conversion */
+  Ref = ADC_SetMux(Channel);
 
   /*
    *  sample ADC readings
@@ -106,14 +422,36 @@ sample:
 
   Value = 0UL;                     /* reset sampling variable */
   Counter = 0;                     /* reset counter */
+#ifdef ADC_ADAPTIVE
+  SumSq = 0UL;                     /* reset sum of squares */
+#endif
 
   while (Counter < Cfg.Samples)    /* take samples */
   {
 //    TODO  pridaj kod pre LGT (2 merania + priemerovanie + odratanie >> 7) pre LGT
-    ADCSRA |= (1 << ADSC);         /* start conversion */
-    while (ADCSRA & (1 << ADSC));  /* wait until conversion is done */
+    ADC_Conversion();              /* run conversion */
 
-    Value += ADCW;                 /* add ADC reading */
+    Sample = ADCW;                 /* get ADC reading */
+    Value += Sample;               /* add ADC reading */
+
+#ifdef ADC_ADAPTIVE
+    /* track spread of readings */
+    if (Counter == 0) First = Sample;   /* first reading */
+    Diff = Sample - First;              /* difference to first reading */
+    SumSq += (int32_t)Diff * Diff;      /* add square */
+#endif
+
+#ifdef ADC_STATE_CACHE
+    /* sticky bandgap reference: switch back to Vcc for high readings */
+    if (Sticky && (Sample > 1000))      /* > about 1.07V */
+    {
+      Sticky = 0;                       /* don't try again */
+      Channel &= ~ADC_REF_MASK;         /* clear reference bits */
+      Channel |= ADC_REF_VCC;           /* select Vcc reference */
+
+      goto sample;                      /* re-run sampling */
+    }
+#endif
 
     /* auto-switch voltage reference for low readings */
     if (Counter == 4)                   /* 5 samples */
@@ -123,7 +461,7 @@ sample:
       {
         if (Ref != ADC_REF_BANDGAP)     /* bandgap ref not selected */
         {
-          if (Cfg.AutoScale == 1)       /* autoscaling enabled */
+          if (Scale == 1)               /* autoscaling enabled */
           {
             Channel &= ~ADC_REF_MASK;     /* clear reference bits */
             Channel |= ADC_REF_BANDGAP;   /* select bandgap reference */
@@ -135,34 +473,491 @@ sample:
     }
 
     Counter++;                     /* another sample done */
+
+#ifdef ADC_ADAPTIVE
+    /* early termination for stable readings */
+    if ((Counter >= ADC_SAMPLES_MIN) && (Cfg.Tolerance > 0))
+    {
+      if (ADC_Stable(Value - (uint32_t)First * Counter, SumSq, Counter))
+        break;                     /* end sampling */
+    }
+#endif
   }
 
+#ifdef ADC_ADAPTIVE
+  Cfg.SamplesUsed = Counter;       /* report number of samples */
+#endif
+
+#ifdef ADC_STATE_CACHE
+  /* remember reference for sticky auto-scaling */
+  ADC_UpdateRef(Channel & ADC_CHAN_MASK, Ref);
+#endif
+
+  /* convert ADC reading to voltage */
+  return ADC_ScaleU(Value, Ref, Counter);
+}
+
+
+#ifdef ADC_MULTI
+
+/*
+ *  read several ADC channels in one pass and return voltages in mV
+ *  - conversions are interleaved (round robin), so the readings of
+ *    all channels are close in time
+ *  - one reference setup and one dummy conversion for all channels
+ *  - common reference: Vcc, or bandgap when all channels are below 1V
+ *    (auto-scaling)
+ *  - the S&H cap isn't precharged to the channel's voltage, so use it
+ *    for low impedance sources only (not for Rh)
+ *
+ *  requires:
+ *  - Count: number of channels (1 - ADC_MULTI_MAX)
+ *  - Channels: array of ADC MUX input channels (see ReadU())
+ *  - U: array for voltages in mV
+ */
+
+void ReadU_Multi(uint8_t Count, uint8_t *Channels, uint16_t *U)
+{
+  uint8_t           Counter;       /* loop counter */
+  uint8_t           n;             /* channel counter */
+  uint8_t           Ref;           /* voltage reference register bits */
+  uint8_t           Scale;         /* auto-scaling flag */
+  uint8_t           Low;           /* flag for low voltages */
+  uint32_t          Value[ADC_MULTI_MAX];     /* ADC values */
+
+#ifdef ADC_ASYNC
+  /* blocking reads and an async run can't share the ADC */
+  if (ADC_Run.Flags & ADC_RUN_BUSY)     /* async run pending */
+    ADC_Stop();                         /* abort it */
+#endif
+
+  if (Count > ADC_MULTI_MAX) Count = ADC_MULTI_MAX;
+
+  Scale = Cfg.AutoScale;           /* auto-scaling */
+  Ref = ADC_REF_VCC;               /* start with AVcc as voltage reference */
+
+sample:
+
+  /* set first channel and reference, and perform dummy conversion */
+  Ref = ADC_SetMux((Channels[0] & ADC_CHAN_MASK) | Ref);
+
   /*
-   *  convert ADC reading to voltage
-   *  - single sample: U = ADC reading * U_ref / 1024
+   *  sample ADC readings
    */
 
+  n = 0;
+  while (n < Count)                /* reset sampling variables */
+  {
+    Value[n] = 0UL;
+    n++;
+  }
+
+  Counter = 0;                     /* reset counter */
+
+  while (Counter < Cfg.Samples)    /* take samples */
+  {
+    /* one reading per channel */
+    n = 0;
+    while (n < Count)
+    {
+      /* select channel (same reference, no need to wait) */
+      ADMUX = (Channels[n] & ADC_CHAN_MASK) | Ref;
+      ADC_Conversion();            /* run conversion */
+      Value[n] += ADCW;            /* add ADC reading */
+      n++;
+    }
+
+    /* auto-switch voltage reference when all voltages are low */
+    if ((Counter == 4) && (Scale == 1) && (Ref != ADC_REF_BANDGAP))
+    {
+      Low = 1;
+      n = 0;
+      while (n < Count)
+      {
+        if ((uint16_t)Value[n] >= 1024) Low = 0;  /* >= 1V (5V / 5 samples) */
+        n++;
+      }
+
+      if (Low)                     /* all below 1V */
+      {
+        Ref = ADC_REF_BANDGAP;     /* select bandgap reference */
+        goto sample;               /* re-run sampling */
+      }
+    }
+
+    Counter++;                     /* another sample done */
+  }
+
+  /* convert ADC readings to voltages */
+  n = 0;
+  while (n < Count)
+  {
+    U[n] = ADC_ScaleU(Value[n], Ref, Counter);
+    n++;
+  }
+}
+
+#endif // ADC_MULTI
+
+
+#ifdef ADC_OVERSAMPLING
+
+/*
+ *  read ADC channel with oversampling and return voltage in V
+ *  - oversample and decimate: 4^n readings, sum >> n
+ *    gives a resolution of 10 + n bits
+ *  - requires some noise (about 1 LSB) at the ADC input for the
+ *    additional bits to be meaningful
+ *  - reference selection and auto-scaling like ReadU()
+ *  - n = 2 (16 readings) is faster than ReadU() with the default
+ *    of 25 samples
+ *
+ *  requires:
+ *  - Channel: ADC MUX input channel (see ReadU())
+ *    optionally with register bits of a voltage reference (ADC_REF_*)
+ *    to force that reference (no auto-scaling)
+ *  - Bits: number of additional bits (1-3)
+ *
+ *  returns:
+ *  - voltage in V
+ */
+
+uint32_t ReadU_uV(uint8_t Channel, uint8_t Bits)
+{
+  uint8_t           Counter;       /* loop counter */
+  uint8_t           Samples;       /* number of readings */
+  uint8_t           Ref;           /* voltage reference register bits */
+  uint8_t           Scale;         /* auto-scaling flag */
+  uint16_t          U_Ref;         /* voltage of reference (mV) */
+  uint32_t          Value;         /* ADC value */
+  uint32_t          Temp;          /* temporary value */
+
+#ifdef ADC_ASYNC
+  /* blocking reads and an async run can't share the ADC */
+  if (ADC_Run.Flags & ADC_RUN_BUSY)     /* async run pending */
+    ADC_Stop();                         /* abort it */
+#endif
+
+  Samples = 1 << (Bits * 2);       /* 4^n readings */
+  Scale = Cfg.AutoScale;           /* auto-scaling */
+
+  /* prepare bitfield for register: start with AVcc as voltage reference */
+  Ref = Channel & ADC_REF_MASK;    /* get forced reference */
+  Channel &= ADC_CHAN_MASK;        /* filter reg bits for MUX channel */
+  if (Ref)                         /* forced reference */
+  {
+    Channel |= Ref;                /* add bits for voltage reference */
+    Scale = 0;                     /* no auto-scaling */
+  }
+  else                             /* auto-scaling */
+  {
+    Channel |= ADC_REF_VCC;        /* add bits for voltage reference: AVcc */
+  }
+
+sample:
+
+  /* set channel and reference, and perform dummy conversion */
+  Ref = ADC_SetMux(Channel);
+
+  /*
+   *  sample ADC readings
+   */
+
+  Value = 0UL;                     /* reset sampling variable */
+  Counter = 0;                     /* reset counter */
+
+  while (Counter < Samples)        /* take samples */
+  {
+    ADC_Conversion();              /* run conversion */
+    Value += ADCW;                 /* add ADC reading */
+
+    /* auto-switch voltage reference for low readings */
+    if (Counter == 3)                   /* 4 samples */
+    {
+      if ((uint16_t)Value < 820)        /* < 1V (5V / 4 samples) */
+      {
+        if ((Ref != ADC_REF_BANDGAP) && (Scale == 1))
+        {
+          Channel &= ~ADC_REF_MASK;     /* clear reference bits */
+          Channel |= ADC_REF_BANDGAP;   /* select bandgap reference */
+
+          goto sample;                  /* re-run sampling */
+        }
+      }
+    }
+
+    Counter++;                     /* another sample done */
+  }
+
+  /* decimate: sum >> n gives reading with 10 + n bits */
+  Value >>= Bits;
+
   /* get voltage of reference used */
   if (Ref == ADC_REF_BANDGAP)      /* bandgap reference */
-    U = Cfg.Bandgap;                 /* voltage of bandgap reference */
+    U_Ref = Cfg.Bandgap;             /* voltage of bandgap reference */
   else                             /* Vcc as reference */
-    U = Cfg.Vcc;                     /* voltage of Vcc */   
+    U_Ref = Cfg.Vcc;                 /* voltage of Vcc */   
 
-  /* convert to voltage; */
-  Value *= U;                      /* ADC readings * U_ref */
-//  Value += 511 * Cfg.Samples;      /* automagic rounding */
-  Value /= 1024;                   /* / 1024 for 10bit ADC */
-//  todo LGT!!!!
+  /*
+   *  convert to voltage
+   *  - U = reading * U_ref / 2^(10 + n)
+   *  - split into integer part and remainder to stay within 32 bits
+   */
 
-  /* de-sample to get average voltage */
-  Value /= Cfg.Samples;
-  U = (uint16_t)Value;
+  Value *= U_Ref;                  /* reading * U_ref (mV) */
+  Bits += 10;                      /* resolution */
+  Temp = Value & ((1UL << Bits) - 1);   /* remainder */
+  Value >>= Bits;                  /* integer part (mV) */
+  Value *= 1000;                   /* scale to V */
+  Temp *= 1000;                    /* scale to V */
+  Temp >>= Bits;
+  Value += Temp;                   /* voltage in V */
+
+  return Value;
+}
 
-// TODO: do we need a sanity check for U <= Vcc?
+#endif // ADC_OVERSAMPLING
+
+
+#ifdef ADC_NOISE_REDUCTION
+
+/*
+ *  read ADC channel in ADC noise reduction sleep mode
+ *  - same as ReadU(), but each conversion runs while the MCU sleeps
+ *  - lower noise floor, intended for low voltages and the
+ *    bandgap reference
+ *  - requires enabled interrupts (otherwise same as ReadU())
+ *
+ *  requires:
+ *  - Channel: ADC MUX input channel (see ReadU())
+ */
 
-  return U; 
+uint16_t ReadU_Sleep(uint8_t Channel)
+{
+  uint16_t          U;             /* return value (mV) */
+
+  ADC_Sleep = 1;                   /* select sleep mode */
+  U = ReadU(Channel);
+  ADC_Sleep = 0;                   /* back to busy waiting */
+
+  return U;
+}
+
+#endif // ADC_NOISE_REDUCTION
+
+
+
+#ifdef ADC_ASYNC
+
+/* ************************************************************************
+ *   interrupt-driven sampling
+ * ************************************************************************ */
+
+/*
+ *  start sampling run in background
+ *  - same as ReadU(), but returns right after starting the ADC
+ *  - ADC runs in free running mode and the ADC complete interrupt
+ *    sums up the readings
+ *  - takes Cfg.Samples readings
+ *  - use ADC_Poll() to check for the run being finished and
+ *    ADC_Collect() to get the voltage
+ *  - don't change the ADC setup while the run is pending
+ *  - requires enabled interrupts
+ *
+ *  requires:
+ *  - Channel: ADC MUX input channel (see ReadU())
+ */
+
+void ADC_Start(uint8_t Channel)
+{
+  /* prepare bitfield for register: start with AVcc as voltage reference */
+  Channel &= ADC_CHAN_MASK;        /* filter reg bits for MUX channel */
+  Channel |= ADC_REF_VCC;          /* add bits for voltage reference: AVcc */
+
+  ADC_StartRun(Channel);
+}
+
+
+/*
+ *  set up and start sampling run
+ *  - helper for ADC_Start() and ADC_Poll()
+ *
+ *  requires:
+ *  - Bits: ADMUX register bits (MUX channel and reference)
+ */
+
+void ADC_StartRun(uint8_t Bits)
+{
+  /* make sure a former run is stopped */
+  ADC_Stop();
+
+  /* set up run */
+  ADC_Run.Value = 0UL;             /* reset sampling variable */
+  ADC_Run.Counter = 0;             /* reset counter */
+  ADC_Run.Samples = Cfg.Samples;   /* number of samples to take */
+  ADC_Run.Channel = Bits;          /* channel and reference */
+  /* set channel and reference, and perform dummy conversion */
+  ADC_Run.Ref = ADC_SetMux(Bits);
+  ADC_Run.Flags = ADC_RUN_BUSY;
+
+  /* free running mode */
+  ADCSRB &= ~((1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0));
+
+  /*
+   *  start ADC
+   *  - auto trigger and ADC complete interrupt
+   *  - writing 1 to ADIF clears a pending interrupt flag
+   */
+
+  ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIF) | (1 << ADIE) | ADC_CLOCK_DIV;
+}
+
+
+/*
+ *  stop a pending sampling run
+ *  - keeps the readings taken so far
+ */
+
+void ADC_Stop(void)
+{
+  /* disable auto trigger and ADC complete interrupt */
+  ADCSRA = (1 << ADEN) | ADC_CLOCK_DIV;
+
+  /* wait for a running conversion to finish */
+  while (ADCSRA & (1 << ADSC));
+
+  ADC_Run.Flags &= ~ADC_RUN_BUSY;  /* clear busy flag */
+}
+
+
+/*
+ *  check if sampling run is finished
+ *  - re-runs sampling with the bandgap reference for low voltages
+ *    when auto-scaling is enabled (like ReadU())
+ *
+ *  returns:
+ *  - 0 if run is still pending
+ *  - 1 if run is finished (or no run at all)
+ */
+
+uint8_t ADC_Poll(void)
+{
+  uint8_t           Flag = 1;      /* return value */
+  uint8_t           Bits;          /* ADMUX register bits */
+
+  if (ADC_Run.Flags & ADC_RUN_BUSY)     /* run pending */
+  {
+    Flag = 0;                           /* not finished yet */
+  }
+  else if (ADC_Run.Flags & ADC_RUN_RESCALE)  /* low voltage */
+  {
+    /* re-run with bandgap reference */
+    Bits = ADC_Run.Channel;
+    Bits &= ~ADC_REF_MASK;              /* clear reference bits */
+    Bits |= ADC_REF_BANDGAP;            /* select bandgap reference */
+    ADC_StartRun(Bits);
+
+    Flag = 0;                           /* not finished yet */
+  }
+
+  return Flag;
+}
+
+
+/*
+ *  wait for sampling run to finish and return voltage in mV
+ *
+ *  returns:
+ *  - voltage in mV
+ */
+
+uint16_t ADC_Collect(void)
+{
+  uint16_t          U = 0;         /* return value */
+
+  while (ADC_Poll() == 0);         /* wait for run to finish */
+
+  if (ADC_Run.Counter > 0)         /* got readings */
+  {
+    /* convert ADC readings to voltage */
+    U = ADC_ScaleU(ADC_Run.Value, ADC_Run.Ref, ADC_Run.Counter);
+  }
+
+  ADC_Run.Flags = ADC_RUN_IDLE;    /* run is consumed */
+
+  return U;
+}
+
+
+#endif // ADC_ASYNC
+
+
+
+#if defined (ADC_ASYNC) || defined (ADC_NOISE_REDUCTION)
+
+/* ************************************************************************
+ *   ISR
+ * ************************************************************************ */
+
+/*
+ *  ISR for ADC conversion complete
+ *  - sums up readings for the pending async sampling run
+ *  - signals end of conversion for ADC_SleepConversion()
+ */
+
+ISR(ADC_vect, ISR_BLOCK)
+{
+#ifdef ADC_ASYNC
+  uint16_t          Value;         /* ADC reading */
+#endif
+
+  /*
+   *  HINTs:
+   *  - the ADIF interrupt flag is cleared automatically
+   *  - interrupt processing is disabled while this ISR runs
+   *    (no nested interrupts)
+   *  - in free running mode the next conversion is already running
+   */
+
+#ifdef ADC_NOISE_REDUCTION
+  ADC_Wakeup = 1;                  /* conversion done */
+#endif
+
+#ifdef ADC_ASYNC
+  if (! (ADC_Run.Flags & ADC_RUN_BUSY))   /* no async run */
+    return;
+
+  Value = ADCW;                    /* get ADC reading */
+
+  ADC_Run.Value += Value;          /* add ADC reading */
+  ADC_Run.Counter++;               /* another sample done */
+
+  /* auto-switch voltage reference for low readings */
+  if (ADC_Run.Counter == 5)                  /* 5 samples */
+  {
+    if ((uint16_t)ADC_Run.Value < 1024)      /* < 1V (5V / 5 samples) */
+    {
+      if ((ADC_Run.Ref != ADC_REF_BANDGAP) && (Cfg.AutoScale == 1))
+      {
+        /* let ADC_Poll() re-run sampling with bandgap reference */
+        ADC_Run.Flags |= ADC_RUN_RESCALE;
+        ADC_Run.Counter = ADC_Run.Samples;   /* end run */
+      }
+    }
+  }
+
+  if (ADC_Run.Counter >= ADC_Run.Samples)    /* all samples taken */
+  {
+    /* stop free running mode and disable interrupt */
+    ADCSRA = (1 << ADEN) | ADC_CLOCK_DIV;
+    ADC_Run.Flags &= ~ADC_RUN_BUSY;          /* run is finished */
+  }
+#endif
 }
 
+#endif // ADC_ASYNC || ADC_NOISE_REDUCTION
+
+
 
 /* ************************************************************************
  *   convenience functions
@@ -10,7 +10,98 @@
 #ifndef ADC_H
 #define ADC_H
 
+
+#ifdef ADC_ASYNC
+
+/* state flags of async sampling run (ADC_Run_Type.Flags) */
+#define ADC_RUN_IDLE          0b00000000     /* no run */
+#define ADC_RUN_BUSY          0b00000001     /* sampling in progress */
+#define ADC_RUN_RESCALE       0b00000010     /* low voltage: re-run with bandgap */
+
+
+/* async sampling run */
+typedef struct
+{
+  uint32_t          Value;         /* sum of ADC readings */
+  uint8_t           Counter;       /* number of readings taken */
+  uint8_t           Samples;       /* number of readings to take */
+  uint8_t           Channel;       /* ADMUX register bits */
+  uint8_t           Ref;           /* voltage reference register bits */
+  uint8_t           Flags;         /* state flags */
+} ADC_Run_Type;
+
+#endif // ADC_ASYNC
+
+
+#ifdef ADC_ADAPTIVE
+
+/* ADC_Stable() keeps its limit within 32 bits up to 16 */
+#if ADC_TOLERANCE > 16
+#error <<< ADC_TOLERANCE: max. 16 >>>
+#endif
+
+#endif // ADC_ADAPTIVE
+
+
+#ifdef ADC_MULTI
+
+/* max. number of channels for ReadU_Multi() */
+#define ADC_MULTI_MAX         3
+
+#endif // ADC_MULTI
+
+
+#ifdef ADC_STATE_CACHE
+
+/* ADC state flags (ADC_State_Type.Flags) */
+#define ADC_STATE_VALID       0b00000001     /* ADC is up to date */
+
+
+/* cached state of ADC and voltage reference */
+typedef struct
+{
+  uint8_t           Flags;         /* state flags */
+  uint8_t           LowMask;       /* channels with low voltage lately */
+} ADC_State_Type;
+
+extern ADC_State_Type  ADC_State;
+
+#endif // ADC_STATE_CACHE
+
+
+extern uint8_t ADC_SetMux(uint8_t Bits);
+#ifdef ADC_ADAPTIVE
+extern uint8_t ADC_Stable(int32_t Sum, uint32_t SumSq, uint8_t n);
+#endif
+extern uint16_t ADC_ScaleU(uint32_t Value, uint8_t Ref, uint8_t Samples);
+
+#ifdef ADC_STATE_CACHE
+extern uint8_t ADC_StartRef(uint8_t Channel);
+extern void ADC_UpdateRef(uint8_t Channel, uint8_t Ref);
+#endif
+extern void ADC_Conversion(void);
+#ifdef ADC_NOISE_REDUCTION
+extern void ADC_SleepConversion(void);
+#endif
+
 extern uint16_t ReadU(uint8_t Channel);
+#ifdef ADC_MULTI
+extern void ReadU_Multi(uint8_t Count, uint8_t *Channels, uint16_t *U);
+#endif
+#ifdef ADC_OVERSAMPLING
+extern uint32_t ReadU_uV(uint8_t Channel, uint8_t Bits);
+#endif
+#ifdef ADC_NOISE_REDUCTION
+extern uint16_t ReadU_Sleep(uint8_t Channel);
+#endif
+
+#ifdef ADC_ASYNC
+extern void ADC_Start(uint8_t Channel);
+extern void ADC_StartRun(uint8_t Bits);
+extern void ADC_Stop(void);
+extern uint8_t ADC_Poll(void);
+extern uint16_t ADC_Collect(void);
+#endif
 
 extern uint16_t ReadU_5ms(uint8_t Channel);
 extern uint16_t ReadU_20ms(uint8_t Channel);
@@ -20,6 +20,9 @@
  *  local constants
  */
 
+#ifndef SW_FACTOR_SEGMENTS
+/* also read by script/incgen-factor to create factor.h */
+
 /* voltage based factors for large caps (using Rl) */
 /* voltage in mV:                                          300    325    350    375    400    425    450    475    500    525    550    575    600    625    650   675   700   725   750   775   800   825   850   875   900   925   950   975  1000  1025  1050  1075  1100  1125  1150  1175  1200  1225  1250  1275  1300  1325  1350  1375  1400 */
 const uint16_t LargeCap_table[NUM_LARGE_CAP] MEM_TYPE = {23022, 21195, 19629, 18272, 17084, 16036, 15104, 14271, 13520, 12841, 12224, 11660, 11143, 10668, 10229, 9822, 9445, 9093, 8765, 8458, 8170, 7900, 7645, 7405, 7178, 6963, 6760, 6567, 6384, 6209, 6043, 5885, 5733, 5589, 5450, 5318, 5191, 5069, 4952, 4839, 4731, 4627, 4526, 4430, 4336};
@@ -28,6 +31,7 @@ const uint16_t LargeCap_table[NUM_LARGE_CAP] MEM_TYPE = {23022, 21195, 19629, 18
 /* voltages in mV:                                       1000  1050  1100  1150  1200  1250  1300  1350  1400 */
 const uint16_t SmallCap_table[NUM_SMALL_CAP] MEM_TYPE = { 954,  903,  856,  814,  775,  740,  707,  676,  648};
 //const uint16_t SmallCap_table[NUM_SMALL_CAP] MEM_TYPE = {9535, 9026, 8563, 8141, 7753, 7396, 7066, 6761, 6477}; 
+#endif
 
 #ifdef SW_C_VLOSS
 const unsigned char U_loss_str[] MEM_TYPE = "V_l";
@@ -130,34 +134,25 @@ void DelayTimer(void)
 
 
 /*
- *  measure ESR
+ *  set up ESR measurement
  *  - tolerates charge up to about 130mV
  *
  *  requires:
- *  - pointer to cap data structure
+ *  - Cap: pointer to cap data structure
+ *  - ESR: pointer to ESR measurement state
  *
  *  returns:
- *  - ESR in 0.01 Ohm
- *  - UINT16_MAX on any problem
+ *  - 1 on success
+ *  - 0 on any problem
  */
 
-uint16_t MeasureESR(Capacitor_Type *Cap)
+uint8_t ESR_Setup(Capacitor_Type *Cap, ESR_Type *ESR)
 {
-  uint16_t          U_1;           /* voltage at probe 1 with pos. pulse unloaded */
-  uint16_t          U_2;           /* voltage at probe 2 with pos. pulse loaded */
-  uint16_t          U_3;           /* voltage at probe 2 with neg. pulse unloaded */
-  uint16_t          U_4;           /* voltage at probe 1 with neg. pulse loaded */
-  uint8_t           Probe1;        /* probe #1 */
-  uint8_t           Probe2;        /* probe #2 */
-  uint8_t           Bits;          /* register bits for ADC */
-  uint8_t           n;             /* counter */
-  uint32_t          Sum_1;         /* sum #1 */
-  uint32_t          Sum_2;         /* sum #2 */
-  uint32_t          Value;
+  uint16_t          Cycles;        /* MCU cycles for delay */
 
   /* check for a capacitor >= 10nF */
   if (Cap == NULL || CmpValue(Cap->Value, Cap->Scale, 10, -9) < 0)
-    return UINT16_MAX;
+    return 0;
 
   /*
    *  HINT: 
@@ -171,25 +166,21 @@ uint16_t MeasureESR(Capacitor_Type *Cap)
 
   DischargeProbes();                    /* try to discharge probes */
   if (Check.Found == COMP_ERROR)
-    return UINT16_MAX;   /* skip on error */
+    return 0;            /* skip on error */
 
   /* Some testers need additional discharging to lower the cap's residual
      voltage to a reasonable level. */
   DischargeCap(Cap->A, Cap->B);         /* additional discharge */
 
   UpdateProbes2(Cap->A, Cap->B);        /* update probes */
-  Probe1 = Probes.Ch_1;                 /* ADC MUX for probe-1 */
-  Probe2 = Probes.Ch_2;                 /* ADC MUX for probe-2 */
 
-  Probe1 |= ADC_REF_BANDGAP;            /* select bandgap reference */
-  Probe2 |= ADC_REF_BANDGAP;            /* select bandgap reference */
+  /* ADC MUX for probes & select bandgap reference */
+  ESR->Probe1 = Probes.Ch_1 | ADC_REF_BANDGAP;
+  ESR->Probe2 = Probes.Ch_2 | ADC_REF_BANDGAP;
 
-  /* register bits to enable and start ADC */
-  Bits = (1 << ADSC) | (1 << ADEN) | (1 << ADIF) | ADC_CLOCK_DIV;
-
-  /* init variables */
-  Sum_1 = 1;             /* 1 to prevent division by zero */
-  Sum_2 = 1;             /* 1 to prevent division by zero */
+  /* init sums */
+  ESR->Sum_1 = 1;        /* 1 to prevent division by zero */
+  ESR->Sum_2 = 1;        /* 1 to prevent division by zero */
 
   /*
    *  We have to create a delay to shift the middle of the current pulse to
@@ -220,18 +211,63 @@ uint16_t MeasureESR(Capacitor_Type *Cap)
   /* delay for pulse */
   /* MCU cycles for one ADC cycle * 2.5 - MCU cycles for 10s 
      - MCU cycles for half-pulse - 10 */
-  U_1 = ((MCU_CYCLES_PER_ADC * 25) / 10) - (MCU_CYCLES_PER_US * 10) - (MCU_CYCLES_PER_US * 2) - 10;
+  Cycles = ((MCU_CYCLES_PER_ADC * 25) / 10) - (MCU_CYCLES_PER_US * 10) - (MCU_CYCLES_PER_US * 2) - 10;
 
 #if F_CPU == 8000000
   /* magic time shift to compensate missing second half-pulse */
-  U_1 -= 4;
+  Cycles -= 4;
 #endif
 
-  n = (uint8_t)U_1;
-
   /* set up delay timer */
-  if (SetUpDelayTimer(n) == 0)
-    return UINT16_MAX;   /* skip on error */
+  if (SetUpDelayTimer((uint8_t)Cycles) == 0)
+    return 0;            /* skip on error */
+
+  ADC_PORT = 0;          /* set ADC port to low */
+  ADMUX = ESR->Probe1;   /* set input channel to probe-1 & set bandgap ref */
+#ifdef ADC_STATE_CACHE
+  ADC_State.Flags &= ~ADC_STATE_VALID;   /* ADC state unknown */
+#endif
+  wait10ms();            /* time for voltage stabilization */
+
+  ESR->U_2 = 50;         /* don't start with positive half-pulse */
+  ESR->U_4 = 0;          /* start with a negative half-pulse */
+
+  return 1;              /* signal success */
+}
+
+
+/*
+ *  run ESR measurement pulses
+ *  - requires prior call of ESR_Setup()
+ *  - adds the ADC values to the sums of the ESR state
+ *
+ *  requires:
+ *  - ESR: pointer to ESR measurement state
+ *  - n: number of loop runs (pulse pairs)
+ */
+
+void ESR_Pulses(ESR_Type *ESR, uint8_t n)
+{
+  uint16_t          U_1;           /* voltage at probe 1 with pos. pulse unloaded */
+  uint16_t          U_2;           /* voltage at probe 2 with pos. pulse loaded */
+  uint16_t          U_3;           /* voltage at probe 2 with neg. pulse unloaded */
+  uint16_t          U_4;           /* voltage at probe 1 with neg. pulse loaded */
+  uint8_t           Probe1;        /* probe #1 */
+  uint8_t           Probe2;        /* probe #2 */
+  uint8_t           Bits;          /* register bits for ADC */
+  uint32_t          Sum_1;         /* sum #1 */
+  uint32_t          Sum_2;         /* sum #2 */
+
+  /* get state */
+  Probe1 = ESR->Probe1;
+  Probe2 = ESR->Probe2;
+  U_2 = ESR->U_2;
+  U_4 = ESR->U_4;
+  Sum_1 = ESR->Sum_1;
+  Sum_2 = ESR->Sum_2;
+
+  /* register bits to enable and start ADC */
+  Bits = (1 << ADSC) | (1 << ADEN) | (1 << ADIF) | ADC_CLOCK_DIV;
 
   /*
    *  measurement loop:
@@ -243,14 +279,6 @@ uint16_t MeasureESR(Capacitor_Type *Cap)
    *  - 16 & 20 MHz MCUs seem to measure higher ESR values
    */  
 
-  ADC_PORT = 0;          /* set ADC port to low */
-  ADMUX = Probe1;        /* set input channel to probe-1 & set bandgap ref */
-  wait10ms();            /* time for voltage stabilization */
-
-  U_2 = 50;              /* don't start with positive half-pulse */
-  U_4 = 0;               /* start with a negative half-pulse */
-  n = 255;               /* set loop counter */
-
   while (n > 0)
   {
     wdt_reset();                   /* reset watchdog */
@@ -391,9 +419,35 @@ uint16_t MeasureESR(Capacitor_Type *Cap)
   /* update reference source for next ADC run */
   Cfg.Ref = ADC_REF_BANDGAP;       /* we've used the bandgap reference */
 
-  /*
-   *  process measurements
-   */
+  /* save state */
+  ESR->U_2 = U_2;
+  ESR->U_4 = U_4;
+  ESR->Sum_1 = Sum_1;
+  ESR->Sum_2 = Sum_2;
+}
+
+
+/*
+ *  calculate ESR
+ *
+ *  requires:
+ *  - Cap: pointer to cap data structure
+ *  - Sum_1: sum of ADC values without DUT (at RiL)
+ *  - Sum_2: sum of ADC values with DUT
+ *
+ *  returns:
+ *  - ESR in 0.01 Ohm
+ *  - UINT16_MAX on any problem
+ */
+
+uint16_t ESR_Value(Capacitor_Type *Cap, uint32_t Sum_1, uint32_t Sum_2)
+{
+  uint16_t          U_1;           /* raw ESR */
+  uint16_t          U_2;           /* probe resistance */
+#ifdef R_MULTIOFFSET
+  uint8_t           n;             /* index number */
+#endif
+  uint32_t          Value;
 
   if (Sum_2 > Sum_1)               /* valid measurement */
   {
@@ -440,6 +494,31 @@ uint16_t MeasureESR(Capacitor_Type *Cap)
   return UINT16_MAX;
 }
 
+
+/*
+ *  measure ESR
+ *  - tolerates charge up to about 130mV
+ *
+ *  requires:
+ *  - pointer to cap data structure
+ *
+ *  returns:
+ *  - ESR in 0.01 Ohm
+ *  - UINT16_MAX on any problem
+ */
+
+uint16_t MeasureESR(Capacitor_Type *Cap)
+{
+  ESR_Type          ESR;           /* ESR measurement state */
+
+  if (ESR_Setup(Cap, &ESR) == 0)
+    return UINT16_MAX;   /* skip on error */
+
+  ESR_Pulses(&ESR, 255);           /* 255 loop runs */
+
+  return ESR_Value(Cap, ESR.Sum_1, ESR.Sum_2);
+}
+
 #endif // SW_ESR
 
 
@@ -597,6 +676,9 @@ uint16_t MeasureESR(Capacitor_Type *Cap)
 
   ADC_PORT = 0;               /* set ADC port to low */
   ADMUX = Probe1;             /* set input channel to probe-1 & set bandgap ref */
+#ifdef ADC_STATE_CACHE
+  ADC_State.Flags &= ~ADC_STATE_VALID;   /* ADC state unknown */
+#endif
   wait10ms();                 /* time for voltage stabilization */
   ADC_DDR = Probes.Pin_2;     /* pull down probe-2 directly */
   R_PORT = Probes.Rl_1;       /* pull up probe-1 via Rl */
@@ -845,6 +927,147 @@ uint16_t MeasureESR(Capacitor_Type *Cap)
  *
  */
 
+#ifdef SW_CAP_TIMED
+
+/*
+ *  get Timer1 value including overflows
+ *  - helper for TimedCharge()
+ *
+ *  requires:
+ *  - Ticks2: pointer to timer overflow counter
+ *
+ *  returns:
+ *  - timer ticks
+ */
+
+uint32_t TimedCharge_Ticks(uint16_t *Ticks2)
+{
+  uint16_t          Ticks;         /* timer counter */
+
+  Ticks = TCNT1;                   /* get counter value */
+
+  /* catch timer overflow */
+  if (TIFR1 & (1 << TOV1))
+  {
+    /* happens at 262ms for 16MHz or 524ms for 8MHz */
+    TIFR1 = (1 << TOV1);           /* reset flag */
+    wdt_reset();                   /* reset watchdog */
+    (*Ticks2)++;                   /* increase overflow counter */
+    Ticks = TCNT1;                 /* get counter value again */
+  }
+
+  return ((uint32_t)*Ticks2 << 16) | Ticks;
+}
+
+
+/*
+ *  charge DUT via Rl and measure charging time
+ *  - Timer1 measures the time (1/64 clock divider)
+ *  - charges continuously while running single ADC conversions
+ *    instead of 1ms or 10ms pulses with full readings in between
+ *  - the voltage while charging includes the drop across the ESR, so
+ *    we verify the voltage without load and continue charging if it's
+ *    not reached yet (considering the drop for the next run)
+ *  - probe-2 has to be pulled down
+ *
+ *  requires:
+ *  - U_Limit: voltage to reach (in mV)
+ *
+ *  returns:
+ *  - charging time in timer ticks (64 MCU cycles)
+ *  - CAP_TIMED_MAX or more on timeout
+ */
+
+uint32_t TimedCharge(uint16_t U_Limit)
+{
+  uint8_t           Slow = 0;      /* flag for slow charging checked */
+  uint16_t          Ticks2 = 0;    /* timer overflow counter */
+  uint16_t          U_Load;        /* voltage while charging */
+  uint16_t          U_Drop = 0;    /* voltage drop caused by ESR */
+  uint16_t          U_c;           /* voltage without load */
+  uint32_t          Start;         /* start of charging */
+  uint32_t          Time = 0;      /* charging time */
+
+#ifdef SW_PROFILER
+  Prof_Pause();                         /* lend Timer1 */
+#endif
+
+  /* set up timer */
+  TCCR1A = 0;                           /* set default mode */
+  TCCR1B = 0;                           /* timer stopped */
+  TCNT1 = 0;                            /* set Counter1 to 0 */
+  /* clear all flags (input capture, compare A & B, overflow */
+  TIFR1 = (1 << ICF1) | (1 << OCF1B) | (1 << OCF1A) | (1 << TOV1);
+  TCCR1B = (1 << CS11) | (1 << CS10);   /* start timer (1/64 clock divider) */
+
+  while (1)
+  {
+    ADC_SetMux(ADC_REF_VCC | Probes.Ch_1);   /* probe-1, Vcc reference */
+
+    /* charge: probe-1 -- Rl -- Vcc */
+    Start = TimedCharge_Ticks(&Ticks2);
+    R_PORT = Probes.Rl_1;               /* pull-up probe-1 via Rl */
+    R_DDR = Probes.Rl_1;
+
+    while (1)
+    {
+      ADC_Conversion();                 /* single conversion */
+      U_Load = ADC_ScaleU(ADCW, ADC_REF_VCC, 1);
+
+      /* end loop if voltage is reached */
+      if (U_Load >= U_Limit + U_Drop) break;
+
+      /* end loop to check for slow charging or if it takes too long */
+      if ((Ticks2 >= (CAP_TIMED_SLOW >> 16)) && (Slow == 0)) break;
+      if (Ticks2 >= (CAP_TIMED_MAX >> 16)) break;
+
+      TimedCharge_Ticks(&Ticks2);       /* manage overflow */
+    }
+
+    /* stop charging */
+    R_DDR = 0;                          /* set probe-1 to HiZ */
+    R_PORT = 0;                         /* set resistor port to low */
+    Time += TimedCharge_Ticks(&Ticks2) - Start;
+
+    if (Ticks2 >= (CAP_TIMED_MAX >> 16))     /* timeout */
+    {
+      Time = CAP_TIMED_MAX;             /* signal timeout */
+      break;
+    }
+
+    /* end loop if voltage without load is reached */
+    U_c = ReadU(Probes.Ch_1);
+    if (U_c >= U_Limit) break;
+
+    /* end loop if charging is too slow (< 75mV after about 2s) */
+    if (Ticks2 >= (CAP_TIMED_SLOW >> 16))
+    {
+      if ((Slow == 0) && (U_c < 75))
+      {
+        Time = CAP_TIMED_MAX;           /* signal timeout */
+        break;
+      }
+
+      Slow = 1;                         /* checked */
+    }
+
+    /* consider voltage drop for next run */
+    if (U_Load > U_c) U_Drop = U_Load - U_c;
+  }
+
+  TCCR1B = 0;                           /* stop timer */
+
+#ifdef SW_PROFILER
+  /* take Timer1 back and add time */
+  Prof_Continue(TimedCharge_Ticks(&Ticks2) * 64, PROF_MEASURE);
+#endif
+
+  return Time;
+}
+
+#endif // SW_CAP_TIMED
+
+
 /*
  *  measure cap >4.7F between two probe pins
  *
@@ -860,11 +1083,15 @@ uint16_t MeasureESR(Capacitor_Type *Cap)
 
 uint8_t LargeCap(Capacitor_Type *Cap)
 {
+#ifndef SW_CAP_TIMED
   uint8_t           TempByte;      /* temp. value */
+#endif
   uint8_t           Mode;          /* measurement mode */
   int8_t            Scale;         /* capacitance scale */
   uint16_t          TempInt;       /* temp. value */
+#ifndef SW_CAP_TIMED
   uint16_t          Pulses;        /* number of charging pulses */
+#endif
   int16_t           U_Zero;        /* voltage before charging (zero offset) */
   int16_t           U_temp;        /* temporary voltage */
   uint16_t          U_Cap;         /* voltage of DUT */
@@ -872,9 +1099,40 @@ uint8_t LargeCap(Capacitor_Type *Cap)
   uint16_t          U_Leak = 0;    /* voltage drop (leakage current) */
   uint32_t          Raw;           /* raw capacitance value */
   uint32_t          Value;         /* corrected capacitance value */
+#ifdef ADC_MULTI
+  uint8_t           Channels[2];   /* ADC MUX channels */
+  uint16_t          U[2];          /* voltages */
+#endif
+#ifdef SW_CAP_PRESELECT
+  uint8_t           Preselect = 1; /* pre-selection pending */
+#endif
+#ifdef SW_CAP_TIMED
+  uint32_t          Time;          /* charging time */
+#endif
 
   /* set up mode */
+#ifdef SW_CAP_PRESELECT
+  /*
+   *  pre-select charging mode
+   *  - a large discharge time constant indicates a large cap
+   *    (discharged via Rl of both probes)
+   *  - otherwise the first 1ms pulse selects the mode: >1300mV for a
+   *    small cap (SmallCap()), less than CAP_PRESELECT_U for a large
+   *    cap (10ms pulses would stay below 1300mV), 1ms pulses else
+   */
+
+  Mode = PULL_1MS | PULL_UP;       /* start with mid-sized cap (4.7-47uF) */
+#ifdef SW_DISCHARGE_MODEL
+  if ((Check.Tau[Probes.ID_1] >= CAP_PRESELECT_TAU) ||
+      (Check.Tau[Probes.ID_2] >= CAP_PRESELECT_TAU))
+  {
+    Mode = PULL_10MS | PULL_UP;    /* large cap (>47uF) */
+    Preselect = 0;                 /* done */
+  }
+#endif
+#else
   Mode = PULL_10MS | PULL_UP;      /* start with large cap (>47uF) */
+#endif
 
   /*
    *  We charge the DUT with up to 500 pulses each 10ms long until the
@@ -894,7 +1152,9 @@ uint8_t LargeCap(Capacitor_Type *Cap)
    *  The Analog Input Resistance of the ADC is 100MOhm typically.
    */
 
+#ifndef SW_CAP_TIMED
 large_cap:
+#endif
 
   /* prepare probes */
   DischargeProbes();                    /* try to discharge probes */
@@ -914,13 +1174,58 @@ large_cap:
   ADC_DDR = Probes.Pin_2;          /* pull down probe-2 directly */
   R_PORT = Probes.Rl_2;            /* pull up probe-2 via Rl */
   R_DDR = Probes.Rl_2;             /* enable pull-up */
+#ifdef ADC_MULTI
+  Channels[0] = Probes.Ch_1;
+  Channels[1] = Probes.Ch_2;
+  ReadU_Multi(2, Channels, U);     /* read both probes in one pass */
+  U_Zero = U[0] - U[1];            /* voltage at probe-1 - probe-2 */
+#else
   U_Zero = ReadU(Probes.Ch_1);     /* get voltage at probe-1 */
   U_Zero -= ReadU(Probes.Ch_2);    /* - voltage at probe-2 */
+#endif
 
   /* set probes: Gnd -- probe-2 / probe-1 -- HiZ */
   R_PORT = 0;                      /* set resistor port to low */
   R_DDR = 0;                       /* set resistor port to HiZ */  
 
+#ifdef SW_CAP_TIMED
+  /*
+   *  charge DUT continuously until it exceeds 300mV
+   *  - measure voltage after charging has stopped
+   *  - time limit of about 5s like the charge pulses
+   */
+
+  Time = TimedCharge(300 + U_Zero);     /* charge and get time */
+  if (Time >= CAP_TIMED_MAX)            /* timeout */
+    return 1;                           /* signal too high capacitance */
+
+  U_Cap = ReadU(Probes.Ch_1);           /* get voltage */
+
+  /* consider zero offset */
+  U_temp = (int16_t)U_Cap;         /* explicit type conversion */
+  if (U_temp > U_Zero)             /* voltage higher than zero offset */
+    U_temp -= U_Zero;                   /* subtract zero offset */
+  else                             /* shouldn't happen but you never know */
+    U_temp = 0;                         /* assume 0V */
+  U_Cap = (uint16_t)U_temp;        /* take result */
+
+  /* convert time into s (rounded) */
+  Time *= 64;                           /* MCU cycles */
+  Time += MCU_CYCLES_PER_US / 2;        /* for rounding */
+  Time /= MCU_CYCLES_PER_US;            /* s */
+
+  /* if 1300mV are reached or it took less than 205s, we got a small cap */
+  if ((U_Cap > 1300) || (Time < 205))
+    return 2;                           /* signal low capacitance (<4.7F) */
+
+  /* more than 2ms equals 10ms pulses (>47F) */
+  if (Time > 2000)
+    Mode = PULL_10MS | PULL_UP;
+  else
+    Mode = PULL_1MS | PULL_UP;
+
+  TempInt = Time / 1000;                /* time in ms for leakage check */
+#else
   /* charge DUT with up to 500 pulses until it exceeds 300mV */
   /* pulse: probe-1 -- Rl -- Vcc */
   Pulses = 0;                      /* reset number of pulses */
@@ -939,6 +1244,19 @@ large_cap:
       U_temp = 0;                       /* assume 0V */
     U_Cap = (uint16_t)U_temp;      /* take result */
 
+#ifdef SW_CAP_PRESELECT
+    /* first 1ms pulse indicates a large cap */
+    if (Preselect && (U_Cap < CAP_PRESELECT_U))
+    {
+      /* change to large cap (>47uF) */
+      Mode = PULL_10MS | PULL_UP;  /* set mode to 10ms charging pulses */
+      Preselect = 0;               /* done */
+      goto large_cap;              /* and re-run */
+    }
+
+    Preselect = 0;                 /* done */
+#endif
+
     /* end loop if charging is too slow */
     if ((Pulses == 126) && (U_Cap < 75))
       TempByte = 0;
@@ -973,6 +1291,9 @@ large_cap:
     return 2;                         /* signal low capacitance (<4.7F) */
   }
 
+  TempInt = Pulses;                   /* same number of loop runs (pulses) */
+#endif
+
   /*
    *  Check if DUT sustains the charge and get the voltage drop.
    *  - Run for about the same time as before (minus the 1 or 10ms charging time).
@@ -984,7 +1305,11 @@ large_cap:
 
   /* no issues so far */
   /* check self-discharging for measuring period */
-  TempInt = Pulses;                   /* same number of loop runs (pulses) */
+#ifdef SW_CAP_TIMED
+  /* same time as charging */
+  if (TempInt > 0) MilliSleep(TempInt);
+  TempInt = 1;                        /* single reading */
+#endif
   while (TempInt > 0)                 /* delay loop */
   {
     TempInt--;                        /* decrease timeout */
@@ -1065,10 +1390,35 @@ large_cap:
   /* no issues so far */
   Scale = -9;                           /* factor is scaled to nF */
   /* get interpolated factor from table */
+#ifdef SW_CAP_TIMED
+  /* C = time (ms) * factor */
+  /*
+   *  The table is based on charging from 0V to U with U_in = 5V.
+   *  We charged from U_Zero to U_Zero + U, so the table's voltage is
+   *  U * 5V / (Vcc - U_Zero).
+   */
+  U_temp = Cfg.Vcc - U_Zero;            /* voltage across Rl at start */
+  Value = (uint32_t)(U_Cap + U_Drop) * 5000;
+  Value += U_temp / 2;                  /* for rounding */
+  Value /= U_temp;
+  TempInt = GetFactor((uint16_t)Value, TABLE_LARGE_CAP);
+  Raw = Time;                           /* charging time (s) */
+  if (Raw > (UINT32_MAX / TempInt))     /* prevent overflow */
+  {
+    Raw /= 1000;                        /* ms */
+    Raw *= TempInt;
+  }
+  else
+  {
+    Raw *= TempInt;
+    Raw /= 1000;                        /* ms */
+  }
+#else
   Raw = GetFactor(U_Cap + U_Drop, TABLE_LARGE_CAP);
   Raw *= Pulses;                        /* C = pulses * factor */
   if (Mode & PULL_10MS)
     Raw *= 10;      /* *10 for 10ms charging pulses */
+#endif
 
   if (Raw > (UINT32_MAX / 1000))        /* scale down if C >4.3mF */
   {
@@ -1078,6 +1428,20 @@ large_cap:
 
   Value = Raw;                          /* copy raw value */
 
+#ifdef SW_CAP_TIMED
+  /*
+   *  Continuous charging has no pauses for readings, so the systematic
+   *  error of the pulse method (CAP_FACTOR_MID and CAP_FACTOR_LARGE)
+   *  doesn't apply. But the table assumes R = 702 Ohms while the
+   *  charging current flows through RiH, Rl and RiL. Correct C by
+   *  R_table / R_charge (in 0.1%).
+   *  - tested with the simulator against the pulse method:
+   *    4.7F - 10mF within 1%
+   */
+
+  Value *= 1000;                        /* scale for 0.1% resolution */
+  Value /= ((uint32_t)(R_LOW * 10 + NV.RiH + NV.RiL) * 1000) / CAP_TIMED_R_TABLE;
+#else
   /*
    *  We got a systematic error which needs to be compensated.
    *  The compensation factor can vary with the tester model.
@@ -1088,6 +1452,7 @@ large_cap:
     Value /= (1000 - CAP_FACTOR_LARGE);    /* apply factor (in 0.1%) */
   else                           /* cap 4.7-47F */
     Value /= (1000 - CAP_FACTOR_MID);      /* apply factor (in 0.1%) */
+#endif
 
   /* copy data */
   Cap->A = Probes.ID_2;     /* pull-down probe pin */
@@ -1193,8 +1558,15 @@ uint8_t SmallCap(Capacitor_Type *Cap)
   ADMUX = ADC_REF_VCC | Probes.Ch_1;    /* switch ADC multiplexer to probe 1 */
                                         /* and set AREF to Vcc */
   ADCSRA = ADC_CLOCK_DIV;               /* disable ADC, but keep clock dividers */
+#ifdef ADC_STATE_CACHE
+  ADC_State.Flags &= ~ADC_STATE_VALID;   /* ADC state unknown */
+#endif
   wait200us();
 
+#ifdef SW_PROFILER
+  Prof_Pause();                         /* lend Timer1 */
+#endif
+
   /* set up timer */
   TCCR1A = 0;                           /* set default mode */
   TCCR1B = 0;                           /* set more timer modes */
@@ -1258,6 +1630,11 @@ uint8_t SmallCap(Capacitor_Type *Cap)
     Ticks2++;                           /* increase overflow counter */
   }
 
+#ifdef SW_PROFILER
+  /* take Timer1 back and add charging time */
+  Prof_Continue(((uint32_t)Ticks2 << 16) | TCNT1, PROF_MEASURE);
+#endif
+
   /* enable ADC again */
   ADCSRA = (1 << ADEN) | (1 << ADIF) | ADC_CLOCK_DIV;
   ADCSRB &= ~(1 << ACME);     /* disable ADC multiplexer as negative input */
@@ -1365,9 +1742,15 @@ uint8_t SmallCap(Capacitor_Type *Cap)
      R_DDR = 0;                       /* stop discharging */
 
      Cfg.AutoScale = 0;               /* disable auto scaling */
+#ifdef ADC_NOISE_REDUCTION
+     Ticks = ReadU_Sleep(Probes.Ch_1);     /* U_c with Vcc reference */
+     Cfg.AutoScale = 1;                    /* enable auto scaling again */
+     Ticks2 = ReadU_Sleep(Probes.Ch_1);    /* U_c with bandgap reference */
+#else
      Ticks = ReadU(Probes.Ch_1);      /* U_c with Vcc reference */
      Cfg.AutoScale = 1;               /* enable auto scaling again */
      Ticks2 = ReadU(Probes.Ch_1);     /* U_c with bandgap reference */
+#endif
 
      R_DDR = Probes.Rh_1;             /* resume discharging */
 
@@ -1616,6 +1999,191 @@ void MeasureCap(uint8_t Probe1, uint8_t Probe2, uint8_t ID)
 }
 
 
+#ifdef SW_CAP_SCAN
+
+/*
+ *  quick check for an open probe pair
+ *  - charges probe-1 via Rh until the voltage reaches the bandgap
+ *    reference like SmallCap(), but stops after the time needed for
+ *    the zero offset plus 5pF (limit for ghosts)
+ *  - probe-3 is driven the same way as a guard, so a cap between
+ *    probe-3 and one of the other probes doesn't add to the pair
+ *  - probes have to be set by UpdateProbes2() and discharged
+ *
+ *  returns:
+ *  - 1 if probe pair might store charge
+ *  - 0 if probe pair is open
+ */
+
+uint8_t ScreenCap(void)
+{
+  uint8_t           Flags;         /* Timer1 flags */
+  uint16_t          Limit;         /* timeout (timer ticks) */
+  uint32_t          Value;         /* temp. value */
+
+  /*
+   *  timeout: ticks for zero offset plus 5pF
+   *  - reverse calculation of SmallCap()
+   */
+
+#ifdef CAP_MULTIOFFSET
+  Value = NV.CapZero[GetOffsetIndex(Probes.ID_1, Probes.ID_2)];
+#else
+  Value = NV.CapZero;
+#endif
+  Value += 5;                           /* add limit for ghosts (pF) */
+  Value *= (F_CPU / 10000);             /* time scale */
+#if CAP_FACTOR_SMALL != 0
+  Value *= (1000 - CAP_FACTOR_SMALL);   /* apply factor (in 0.1%) */
+  Value /= 1000;
+#endif
+  Value /= GetFactor(Cfg.Bandgap + NV.CompOffset, TABLE_SMALL_CAP);
+  Value += 2;                           /* processing time overhead */
+  Limit = (uint16_t)Value;
+
+  /* set probes: Gnd -- all probes / Gnd -- Rh -- probe-1 */
+  R_PORT = 0;                           /* set resistor port to low */
+  /* set ADC probe pins to output mode */
+  ADC_DDR = (1 << TP1) | (1 << TP2) | (1 << TP3);
+  ADC_PORT = 0;                         /* set ADC port to low */
+  R_DDR = Probes.Rh_1 | Probes.Rh_3;    /* pull-down probe-1/3 via Rh */
+
+  /* set up analog comparator */
+  ADCSRB = (1 << ACME);                 /* use ADC multiplexer as negative input */
+  ACSR = (1 << ACBG) | (1 << ACIC);     /* use bandgap as positive input, trigger Timer1 */
+  ADMUX = ADC_REF_VCC | Probes.Ch_1;    /* switch ADC multiplexer to probe 1 */
+                                        /* and set AREF to Vcc */
+  ADCSRA = ADC_CLOCK_DIV;               /* disable ADC, but keep clock dividers */
+#ifdef ADC_STATE_CACHE
+  ADC_State.Flags &= ~ADC_STATE_VALID;   /* ADC state unknown */
+#endif
+  wait200us();
+
+#ifdef SW_PROFILER
+  Prof_Pause();                         /* lend Timer1 */
+#endif
+
+  /* set up timer */
+  TCCR1A = 0;                           /* set default mode */
+  TCCR1B = 0;                           /* set more timer modes */
+  TCNT1 = 0;                            /* set Counter1 to 0 */
+  /* clear all flags (input capture, compare A & B, overflow */
+  TIFR1 = (1 << ICF1) | (1 << OCF1B) | (1 << OCF1A) | (1 << TOV1);
+  R_PORT = Probes.Rh_1 | Probes.Rh_3;   /* pull-up probe-1/3 via Rh */
+
+  /* start timer (1/1 clock divider) and start charging */
+  TCCR1B = (1 << CS10);
+  ADC_DDR = Probes.Pin_2;               /* keep just probe-2 pulled down */
+
+  /* run until voltage is reached or timeout */
+  while (1)
+  {
+    Flags = TIFR1;                      /* get Timer1 flags */
+    if (Flags & (1 << ICF1)) break;     /* voltage reached */
+    if (TCNT1 > Limit) break;           /* timeout */
+  }
+
+  /* stop counter */
+  TCCR1B = 0;                           /* stop timer */
+  TIFR1 = (1 << ICF1);                  /* reset Input Capture flag */
+
+  /* discharge probes directly */
+  R_DDR = 0;                            /* set resistor port to HiZ mode */
+  R_PORT = 0;                           /* set resistor port to low */
+  ADC_DDR = (1 << TP1) | (1 << TP2) | (1 << TP3);
+
+#ifdef SW_PROFILER
+  /* take Timer1 back and add charging time */
+  Prof_Continue(TCNT1, PROF_MEASURE);
+#endif
+
+  /* enable ADC again */
+  ADCSRA = (1 << ADEN) | (1 << ADIF) | ADC_CLOCK_DIV;
+  ADCSRB &= ~(1 << ACME);     /* disable ADC multiplexer as negative input */
+
+  if (Flags & (1 << ICF1))    /* voltage reached in time */
+    return 0;                 /* open */
+
+  return 1;
+}
+
+
+/*
+ *  measure capacitance of all probe pairs
+ *  - replaces the MeasureCap() calls for (3,1), (3,2) and (2,1)
+ *  - one discharge for all probe pairs and a quick check for open
+ *    pairs, full measurement just for the remaining pairs
+ *
+ *  requires:
+ *  - Mask: probe pairs to check (bit 0: (3,1), 1: (3,2), 2: (2,1))
+ */
+
+void MeasureCaps(uint8_t Mask)
+{
+  Capacitor_Type    *Cap;               /* pointer to cap data structure */
+  uint8_t           n;                  /* counter */
+  uint8_t           Probe1;             /* ID of probe to be pulled up */
+  uint8_t           Probe2;             /* ID of probe to be pulled down */
+
+  /*
+   *  quick check for open pairs
+   *  - MeasureCap() skips resistors (besides < 10 Ohms) by itself
+   */
+
+  if (Check.Found == COMP_NONE)
+  {
+    DischargeProbes();                  /* discharge once for all pairs */
+    if (Check.Found == COMP_ERROR)      /* discharge problem */
+      Mask = 0;                         /* skip all */
+
+    for (n = 0; n < 3; n++)
+    {
+      /* probe pairs: (3,1), (3,2), (2,1) */
+      Probe1 = (n == 2) ? PROBE_2 : PROBE_3;
+      Probe2 = (n == 1) ? PROBE_2 : PROBE_1;
+
+      if (Mask & (1 << n))              /* check pair */
+      {
+        UpdateProbes2(Probe1, Probe2);  /* update probes */
+        if (ScreenCap() == 0)           /* open pair */
+          Mask &= ~(1 << n);            /* skip it */
+      }
+    }
+
+    /* reset probes */
+    ADC_DDR = 0;                        /* set ADC port to input */
+    R_DDR = 0;                          /* set resistor port to input */
+  }
+
+  Cap = &Caps[0];
+  for (n = 0; n < 3; n++)
+  {
+    Probe1 = (n == 2) ? PROBE_2 : PROBE_3;
+    Probe2 = (n == 1) ? PROBE_2 : PROBE_1;
+
+    if (Mask & (1 << n))                /* might be a cap */
+      MeasureCap(Probe1, Probe2, n);    /* full measurement */
+    else                                /* skipped */
+    {
+      /* reset cap data */
+      Cap->A = 0;
+      Cap->B = 0;
+      Cap->Scale = -12;                 /* pF by default */
+      Cap->Raw = 0;
+      Cap->Value = 0;
+      Cap->I_leak_Value = 0;
+#ifdef SW_C_VLOSS
+      Cap->U_loss = 0;
+#endif
+    }
+
+    Cap++;                              /* next one */
+  }
+}
+
+#endif // SW_CAP_SCAN
+
+
 #ifdef HW_ADJUST_CAP
 
 /*
@@ -1674,6 +2242,9 @@ uint8_t RefCap(void)
   ADMUX = ADC_REF_VCC | TP_CAP;         /* switch ADC multiplexer to cap pin */
                                         /* and set AREF to Vcc */
   ADCSRA = ADC_CLOCK_DIV;               /* disable ADC, but keep clock dividers */
+#ifdef ADC_STATE_CACHE
+  ADC_State.Flags &= ~ADC_STATE_VALID;   /* ADC state unknown */
+#endif
   wait200us();
 
   /* set up timer */
@@ -1756,9 +2327,15 @@ uint8_t RefCap(void)
     ADJUST_DDR &= ~(1 << ADJUST_RH);    /* stop discharging */
 
     Cfg.AutoScale = 0;                  /* disable auto scaling */
+#ifdef ADC_NOISE_REDUCTION
+    Ticks = ReadU_Sleep(TP_CAP);        /* U_c with Vcc reference */
+    Cfg.AutoScale = 1;                  /* enable auto scaling again */
+    Ticks2 = ReadU_Sleep(TP_CAP);       /* U_c with bandgap reference */
+#else
     Ticks = ReadU(TP_CAP);              /* U_c with Vcc reference */
     Cfg.AutoScale = 1;                  /* enable auto scaling again */
     Ticks2 = ReadU(TP_CAP);             /* U_c with bandgap reference */
+#endif
 
     ADJUST_DDR |= (1 << ADJUST_RH);     /* resume discharging */
 
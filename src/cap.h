@@ -15,12 +15,30 @@
 #error <<< select either ESR or OLD_ESR! >>>
 #endif
 
+#if defined(SW_CAP_TIMED) && defined(SW_CAP_PRESELECT)
+#error <<< select either CAP_TIMED or CAP_PRESELECT! >>>
+#endif
+
 
 /* number of entries in data tables */
 #define NUM_LARGE_CAP         46        /* large cap factors */
 
 
 #define NUM_SMALL_CAP         9         /* small cap factors */
+
+/* timed charging (LargeCap()) */
+#ifdef SW_CAP_TIMED
+#define CAP_TIMED_SLOW      ((F_CPU / 2000000) << 16) /* min. 75mV after (ticks, about 2s) */
+#define CAP_TIMED_MAX       ((F_CPU / 800000) << 16)  /* timeout (ticks, about 5s) */
+#define CAP_TIMED_R_TABLE   7020   /* R of LargeCap_table: 680 + 22 Ohms (0.1 Ohms) */
+#endif
+
+/* pre-selection of charging mode (LargeCap()) */
+#ifdef SW_CAP_PRESELECT
+#define CAP_PRESELECT_U     148    /* 1ms pulse: limit for 10ms pulses (mV) */
+#define CAP_PRESELECT_TAU   100    /* discharge: min. for 10ms pulses (ms) */
+#endif
+
 /* multiplicator table IDs */
 #define TABLE_SMALL_CAP       1              /* table for small caps */
 #define TABLE_LARGE_CAP       2              /* table for large caps */
@@ -42,12 +60,35 @@ typedef struct
 } Capacitor_Type;
 
 
+#ifdef SW_ESR
+/* ESR measurement state */
+typedef struct
+{
+  uint32_t          Sum_1;         /* sum of voltages without DUT */
+  uint32_t          Sum_2;         /* sum of voltages with DUT */
+  uint16_t          U_2;           /* last voltage of pos. pulse */
+  uint16_t          U_4;           /* last voltage of neg. pulse */
+  uint8_t           Probe1;        /* ADC MUX for probe-1 */
+  uint8_t           Probe2;        /* ADC MUX for probe-2 */
+} ESR_Type;
+#endif
+
 #if defined (SW_ESR) || defined (SW_OLD_ESR)
 extern uint16_t MeasureESR(Capacitor_Type *Cap);
 #endif
 
+#ifdef SW_ESR_STREAM
+extern uint8_t ESR_Setup(Capacitor_Type *Cap, ESR_Type *ESR);
+extern void ESR_Pulses(ESR_Type *ESR, uint8_t n);
+extern uint16_t ESR_Value(Capacitor_Type *Cap, uint32_t Sum_1, uint32_t Sum_2);
+#endif
+
 extern void MeasureCap(uint8_t Probe1, uint8_t Probe2, uint8_t ID);
 
+#ifdef SW_CAP_SCAN
+extern void MeasureCaps(uint8_t Mask);
+#endif
+
 #ifdef HW_ADJUST_CAP
 extern uint8_t RefCap(void);
 #endif
@@ -448,6 +448,18 @@
 #define SW_INDUCTOR
 
 
+/*
+ *  multi-shot inductance measurement
+ *  - runs 8 shots per measurement mode with a single discharge,
+ *    rejects outliers and averages the remaining times
+ *  - displays the spread of the shots in %
+ *  - requires SW_INDUCTOR
+ *  - uncomment to enable
+ */
+
+//#define SW_INDUCTOR_MULTI
+
+
 /*
  *  ESR measurement
  *  - requires MCU clock >= 8 MHz
@@ -468,6 +480,21 @@
 #define SW_ESR_TOOL
 
 
+/*
+ *  ESR streaming for the ESR tool
+ *  - after measuring the cap the ESR pulses keep running and the
+ *    rolling ESR of the last 256 pulse pairs is shown every
+ *    ESR_STREAM_RATE ms (also via TTL serial with UI_SERIAL_COPY)
+ *  - a key press stops streaming
+ *  - requires SW_ESR_TOOL and SW_ESR
+ *  - uses Timer1
+ *  - uncomment to enable
+ */
+
+//#define SW_ESR_STREAM
+#define ESR_STREAM_RATE       200       /* 200ms */
+
+
 /*
  *  check for rotary encoders
  *  - uncomment to enable
@@ -590,6 +617,114 @@
 #define SW_SCHOTTKY_BJT
 
 
+/*
+ *  probe scheduler
+ *  - skips probe permutations which can't change the result once a
+ *    transistor, Thyristor or TRIAC is identified
+ *  - the verification run (reversed C-E, D-S etc.) is kept
+ *  - uncomment to enable
+ */
+
+//#define SW_PROBE_SCHEDULER
+
+
+/*
+ *  model based discharging of probes
+ *  - reads all probes in rounds and predicts the discharge time by
+ *    fitting an exponential decay instead of polling every 50ms
+ *  - no delays if the probes are discharged already
+ *  - falls back to polling if the voltage doesn't decrease
+ *  - saves the discharge time constants for MeasureCap()
+ *  - uncomment to enable
+ */
+
+//#define SW_DISCHARGE_MODEL
+
+
+/*
+ *  probe state tracker
+ *  - remembers a successful DischargeProbes() run until the probes
+ *    are driven again (UpdateProbes(), PullProbe())
+ *  - the next DischargeProbes() run just checks the probes with a
+ *    single ADC conversion each
+ *  - uncomment to enable
+ */
+
+//#define SW_PROBE_STATE
+
+
+/*
+ *  pre-selection of capacitance measurement
+ *  - LargeCap() starts with a single 1ms charging pulse and selects
+ *    10ms pulses, 1ms pulses or SmallCap() based on the voltage reached
+ *    instead of trying 10ms pulses first
+ *  - with SW_DISCHARGE_MODEL a large discharge time constant selects
+ *    10ms pulses directly
+ *  - uncomment to enable
+ */
+
+//#define SW_CAP_PRESELECT
+
+
+/*
+ *  capacitance scan of all probe pairs
+ *  - discharges once and runs a quick check for open probe pairs
+ *    (zero offset plus 5pF) before the full measurement
+ *  - the full measurement runs just for pairs which might store charge
+ *  - uncomment to enable
+ */
+
+//#define SW_CAP_SCAN
+
+
+/*
+ *  timed charging of large caps
+ *  - charges the cap continuously via Rl and times it with Timer1
+ *    instead of counting 10ms/1ms pulses with a pause for each reading
+ *  - compensates the voltage drop across the cap's ESR while charging
+ *  - corrects C by the charging resistance (Rl, RiH and RiL) instead
+ *    of CAP_FACTOR_MID and CAP_FACTOR_LARGE
+ *  - can't be combined with SW_CAP_PRESELECT
+ *  - uncomment to enable
+ */
+
+//#define SW_CAP_TIMED
+
+
+/*
+ *  fixed-point segments for factor lookups (GetFactor())
+ *  - replaces the tables for caps and inductors by segments of 2^n mV
+ *    with intercept and slope, so a lookup needs no division
+ *  - segments are created by script/incgen-factor (src/factor.h)
+ *  - max. deviation from the tables: 0.3%
+ *    (check with misc/sim: sim -f)
+ *  - needs about 200 bytes more flash
+ *  - uncomment to enable
+ */
+
+//#define SW_FACTOR_SEGMENTS
+
+
+/*
+ *  same-as-last mode for sorting parts
+ *  - the first part found becomes the reference, the following
+ *    probing cycles check just the probe permutations and pairs which
+ *    identified the reference and compare the results
+ *  - displays PASS for the same part or FAIL for a different one,
+ *    which is then probed fully, in front of the part type in line #1
+ *  - the reference is kept until it's reset via the main menu, the
+ *    next part found becomes the new reference
+ *  - compares type, pinout and a key value (R, C, V_f, hFE, V_th or
+ *    V_GS(off) for FETs and IGBTs, V_GT for thyristors and TRIACs)
+ *  - PUT, UJT and Zener diode: type and pinout only
+ *  - LAST_TOLERANCE: tolerance of key value in %
+ *  - uncomment to enable
+ */
+
+//#define SW_SAME_AS_LAST
+#define LAST_TOLERANCE        5         /* 5% */
+
+
 /*
  *  Servo Check
  *  - signal output via OC1B
@@ -651,6 +786,38 @@
 #define SW_CAP_LEAKAGE
 
 
+/*
+ *  capacitor leakage check: logging mode
+ *  - samples leakage current every CAP_LOG_INTERVAL seconds
+ *    while charging and shows the trend in line #4
+ *  - copies samples with timestamp to serial if UI_SERIAL_COPY
+ *    is enabled
+ *  - requires SW_CAP_LEAKAGE and display with more than three lines
+ *  - uses Timer1
+ *  - uncomment to enable
+ */
+
+//#define SW_CAP_LEAKAGE_LOG
+#define CAP_LOG_INTERVAL      2         /* sampling interval in s */
+
+
+/*
+ *  capacitor dielectric absorption and self-discharge check
+ *  - charges cap for CAP_DA_SOAK seconds, monitors self-discharge
+ *    and recovery voltage after a short discharge for CAP_DA_WAIT
+ *    seconds each
+ *  - copies voltage samples with timestamp to serial if
+ *    UI_SERIAL_COPY is enabled
+ *  - requires display with more than three lines
+ *  - uses Timer1
+ *  - uncomment to enable
+ */
+
+//#define SW_CAP_DA
+#define CAP_DA_SOAK           10        /* charging time in s */
+#define CAP_DA_WAIT           10        /* self-discharge and recovery time in s */
+
+
 /*
  *  display reverse hFE for BJTs
  *  - hFE for collector and emitter reversed
@@ -670,6 +837,46 @@
 #define SW_HFE_CURRENT
 
 
+/*
+ *  hFE sweep for BJTs
+ *  - measures hFE at up to 12 operating points (common emitter and
+ *    common collector circuit, Rl or Rh for base and collector/emitter,
+ *    common emitter also with Rl as emitter resistor)
+ *  - sends the points sorted by I_C/I_E as table to serial
+ *    (I_C/I_E, I_B, hFE and circuit type) and the number of points
+ *    with a notice when less than 3 distinct points were found
+ *  - requires UI_SERIAL_COPY
+ *  - uncomment to enable
+ */
+
+//#define SW_HFE_SWEEP
+
+
+/*
+ *  fast gate threshold measurement for MOSFETs and IGBTs
+ *  - keeps the gate close to V_th between the samples instead of
+ *    discharging it completely for each sample
+ *  - stops sampling when the readings are stable (4-10 samples)
+ *  - copies the number of samples to serial if UI_SERIAL_COPY is
+ *    enabled
+ *  - uncomment to enable
+ */
+
+//#define SW_VTH_TRACKING
+
+
+/*
+ *  auto-ranging leakage current measurement (I_R, I_CEO)
+ *  - integrates tiny currents via Rh by oversampling (0.1nA resolution)
+ *  - adds the uncertainty to the I_R and I_CEO serial commands, and to
+ *    the serial copy if UI_SERIAL_COPY is enabled
+ *  - requires ADC_OVERSAMPLING
+ *  - uncomment to enable
+ */
+
+//#define SW_LEAK_RANGING
+
+
 /*
  *  display C_be (base-emitter capacitance) for BJTs
  *  - uncomment to enable
@@ -722,9 +929,11 @@
 //#define SW_R_E24_5_CC         /* E24 5% tolerance, color-code */
 //#define SW_R_E24_1_T          /* E24 1% tolerance, text */
 //#define SW_R_E24_1_CC         /* E24 1% tolerance, color-code */
+//#define SW_R_E48_T            /* E48 2% tolerance, text */
 //#define SW_R_E96_T            /* E96 1% tolerance, text */
 //#define SW_R_E96_CC           /* E96 1% tolerance, color-code */
 //#define SW_R_E96_EIA96        /* E96 1% tolerance, EIA-96 code */
+//#define SW_R_E192_T           /* E192 0.5% tolerance, text */
 
 
 /*
@@ -790,6 +999,19 @@
 //#define SW_DIODE_LED
 
 
+/*
+ *  diode I-V curve
+ *  - measures V_f at four test currents and derives the ideality
+ *    factor and series resistance
+ *  - copies the points to serial if UI_SERIAL_COPY is enabled
+ *  - uses ADC oversampling if ADC_OVERSAMPLING is enabled
+ *  - requires a display with more than 3 text lines
+ *  - uncomment to enable
+ */
+
+//#define SW_DIODE_IV
+
+
 /*
  *  Voltmeter 0-5V DC
  *  - warning: no input protection!!!
@@ -1451,6 +1673,59 @@
 #define ADC_SAMPLES      25
 
 
+/*
+ *  Adaptive number of ADC samples.
+ *  - ReadU() tracks the variance of the readings and stops sampling
+ *    as soon as the standard error of the mean drops below a tolerance
+ *  - Cfg.Samples (ADC_SAMPLES) is the upper bound, ADC_SAMPLES_MIN the
+ *    lower bound (min. 5 for auto-scaling)
+ *  - ADC_TOLERANCE is the default standard error in 1/16 ADC steps
+ *    (max. 16), Cfg.Tolerance can be changed per call (0 disables
+ *    early termination)
+ *  - the number of samples taken is reported in Cfg.SamplesUsed
+ *  - uncomment to enable
+ */
+
+//#define ADC_ADAPTIVE
+#define ADC_SAMPLES_MIN   5
+#define ADC_TOLERANCE     4              /* 0.25 ADC steps */
+
+
+/*
+ *  ADC oversampling and decimation for 11-13 bit resolution.
+ *  - adds ReadU_uV() which returns the voltage in V
+ *  - used for Vf in CheckDiode() and by SmallResistor()
+ *  - uncomment to enable
+ */
+
+//#define ADC_OVERSAMPLING
+
+
+/*
+ *  Cache state of ADC and voltage reference.
+ *  - skips the dummy conversion when the ADC has converted the same
+ *    channel with the same reference lately (no MilliSleep() and no
+ *    wait of 1ms or longer since)
+ *  - sticky auto-scaling: starts with the bandgap reference when the
+ *    last reading of the channel was low, to prevent switching between
+ *    Vcc and bandgap (and waiting for AREF) for each reading
+ *  - uncomment to enable
+ */
+
+//#define ADC_STATE_CACHE
+
+
+/*
+ *  Read several ADC channels in one pass.
+ *  - adds ReadU_Multi() with interleaved conversions of up to three
+ *    channels sharing one reference setup and dummy conversion
+ *  - used by DischargeProbes() and LargeCap()
+ *  - uncomment to enable
+ */
+
+//#define ADC_MULTI
+
+
 /*
  *  100nF AREF buffer capacitor
  *  - used by some MCU boards
@@ -1462,6 +1737,35 @@
 //#define ADC_LARGE_BUFFER_CAP
 
 
+/*
+ *  Interrupt-driven ADC sampling.
+ *  - adds ADC_Start(), ADC_Poll() and ADC_Collect() as non-blocking
+ *    counterpart of ReadU()
+ *  - ADC runs in free running mode and the ADC complete interrupt
+ *    sums up the readings, so the MCU can do other things meanwhile
+ *  - used by the 5V DC voltmeter (SW_METER_5VDC) to update the display
+ *    while sampling
+ *  - uncomment to enable
+ */
+
+//#define ADC_ASYNC
+
+
+/*
+ *  ADC noise reduction sleep mode for selected readings.
+ *  - adds ReadU_Sleep() which halts the MCU during each conversion
+ *  - used for the bandgap self-adjustment in SmallCap() and RefCap()
+ *  - not used by MeasureESR(), since the MCU has to toggle the probes
+ *    during the pulse readings, and the unloaded readings have to be
+ *    taken the same way to keep the difference free of bias
+ *  - lower noise floor and power consumption
+ *  - independent of SAVE_POWER
+ *  - uncomment to enable
+ */
+
+//#define ADC_NOISE_REDUCTION
+
+
 /* ************************************************************************
  *   R & D - meant for firmware developers
  * ************************************************************************ */
@@ -1496,6 +1800,22 @@
 //#define SW_DISPLAY_REG
 
 
+/*
+ *  Profiler for the probing cycle.
+ *  - measures the time spent in DischargeProbes(), CheckProbes(),
+ *    CheckAlternatives(), MeasureCap() and the output of the results
+ *  - time spent in wait*() (1ms and longer) and MilliSleep() is reported
+ *    separately
+ *  - uses Timer1 as free running counter (MCU cycles)
+ *  - outputs the stage times after each probing cycle via TTL serial
+ *    when serial copy (UI_SERIAL_COPY) is enabled, otherwise on the
+ *    display (requires 7 text lines or more)
+ *  - uncomment to enable
+ */
+
+//#define SW_PROFILER
+
+
 /* ************************************************************************
  *   MCU specific setup to support different AVRs
  * ************************************************************************ */
@@ -976,6 +976,17 @@ uint8_t Cmd_I_R(uint8_t Cmd)
   /* send value */
   Display_Value(Semi.I_value, Semi.I_scale, 'A');
 
+#ifdef SW_LEAK_RANGING
+  /* send uncertainty of I_R/I_CEO */
+  if ((Cmd != CMD_I_DSS) && (Semi.I_error > 0))
+  {
+    Display_Space();
+    Display_Char('+');                  /* send: +- */
+    Display_Char('-');
+    Display_Value(Semi.I_error, Semi.I_scale, 'A');
+  }
+#endif
+
   return SIGNAL_OK;
 }
 
@@ -49,6 +49,8 @@
 
 #include "serial.h"
 #include "probes.h"
+#include "profiler.h"
+#include "last.h"
 
 #include "display.h"
 #include "user.h"
@@ -122,6 +124,10 @@ typedef struct
   uint8_t           SleepMode;     /* MCU sleep mode */
 #endif
   uint8_t           Samples;       /* number of ADC samples */
+#ifdef ADC_ADAPTIVE
+  uint8_t           Tolerance;     /* max. standard error (1/16 ADC steps, 0 = off) */
+  uint8_t           SamplesUsed;   /* number of ADC samples used by last ReadU() */
+#endif
   uint8_t           AutoScale;     /* flag to disable/enable ADC auto scaling */
   uint8_t           Ref;           /* track reference source used lastly */
   uint16_t          Bandgap;       /* voltage of internal bandgap reference (mV) */
@@ -147,6 +153,9 @@ typedef struct
   uint8_t           Diodes;        /* number of diodes found */
   uint8_t           Probe;         /* error: probe pin */ 
   uint16_t          U;             /* error: voltage in mV */
+#ifdef SW_DISCHARGE_MODEL
+  uint16_t          Tau[3];        /* discharge time constants in ms */
+#endif
 #ifdef SW_SYMBOLS
   uint8_t           Symbol;        /* symbol ID */
   uint8_t           AltSymbol;     /* symbol ID for alternative component */
@@ -0,0 +1,54 @@
+/* AUTO-GENERATED FILE - DO NOT EDIT */
+
+/*
+ *  fixed-point segments for GetFactor()
+ *  - generated by script/incgen-factor
+ *  - pairs of intercept and slope (change per segment)
+ *  - factor = intercept - ((slope * diff + 2^shift / 2) >> shift)
+ */
+
+#ifndef FACTOR_H
+#define FACTOR_H
+
+
+/* SmallCap_table */
+#define FACTOR_SMALL_CAP_START      1000
+#define FACTOR_SMALL_CAP_SHIFT         5
+#define FACTOR_SMALL_CAP_NUM          13
+#define FACTOR_SMALL_CAP_SEGMENTS \
+  954, 33, 921, 32, 890, 30, 860, 27, 832, 26, 806, 25, 781, 23, 758, 22, 736, 21, 715, 20, 695, 20, 675, 18, 657, 18
+
+/* SmallCap_table (reference) */
+#define FACTOR_SMALL_CAP_REF_STEP     50
+#define FACTOR_SMALL_CAP_REF_NUM       9
+#define FACTOR_SMALL_CAP_REF \
+  954, 903, 856, 814, 775, 740, 707, 676, 648
+
+/* LargeCap_table */
+#define FACTOR_LARGE_CAP_START       300
+#define FACTOR_LARGE_CAP_SHIFT         5
+#define FACTOR_LARGE_CAP_NUM          35
+#define FACTOR_LARGE_CAP_SEGMENTS \
+  22993, 2265, 20724, 1887, 18845, 1595, 17263, 1350, 15910, 1153, 14758, 1010, 13752, 892, 12863, 780, 12082, 697, 11385, 628, 10760, 567, 10192, 510, 9682, 467, 9217, 428, 8789, 391, 8398, 360, 8038, 334, 7704, 310, 7395, 287, 7107, 268, 6840, 251, 6589, 234, 6355, 220, 6135, 207, 5929, 196, 5732, 183, 5549, 174, 5375, 165, 5211, 156, 5054, 148, 4906, 141, 4765, 134, 4631, 128, 4503, 122, 4381, 120
+
+/* LargeCap_table (reference) */
+#define FACTOR_LARGE_CAP_REF_STEP     25
+#define FACTOR_LARGE_CAP_REF_NUM      45
+#define FACTOR_LARGE_CAP_REF \
+  23022, 21195, 19629, 18272, 17084, 16036, 15104, 14271, 13520, 12841, 12224, 11660, 11143, 10668, 10229, 9822, 9445, 9093, 8765, 8458, 8170, 7900, 7645, 7405, 7178, 6963, 6760, 6567, 6384, 6209, 6043, 5885, 5733, 5589, 5450, 5318, 5191, 5069, 4952, 4839, 4731, 4627, 4526, 4430, 4336
+
+/* Inductor_table */
+#define FACTOR_INDUCTOR_START        200
+#define FACTOR_INDUCTOR_SHIFT          4
+#define FACTOR_INDUCTOR_NUM           49
+#define FACTOR_INDUCTOR_SEGMENTS \
+  4481, 357, 4115, 326, 3798, 286, 3509, 241, 3267, 222, 3049, 196, 2850, 174, 2677, 162, 2517, 143, 2373, 131, 2243, 123, 2121, 109, 2011, 103, 1910, 97, 1813, 86, 1726, 83, 1644, 77, 1566, 71, 1495, 68, 1427, 64, 1362, 60, 1303, 58, 1245, 53, 1192, 51, 1141, 50, 1091, 45, 1045, 44, 1001, 43, 958, 41, 918, 40, 878, 38, 840, 36, 804, 36, 769, 35, 734, 33, 701, 33, 668, 31, 637, 31, 606, 30, 576, 30, 546, 30, 516, 29, 487, 30, 457, 30, 426, 31, 396, 32, 363, 34, 329, 40, 289, 40
+
+/* Inductor_table (reference) */
+#define FACTOR_INDUCTOR_REF_STEP      25
+#define FACTOR_INDUCTOR_REF_NUM       32
+#define FACTOR_INDUCTOR_REF \
+  4481, 3923, 3476, 3110, 2804, 2544, 2321, 2128, 1958, 1807, 1673, 1552, 1443, 1343, 1252, 1169, 1091, 1020, 953, 890, 831, 775, 721, 670, 621, 574, 527, 481, 434, 386, 334, 271
+
+
+#endif // FACTOR_H
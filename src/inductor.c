@@ -22,9 +22,13 @@
  *  local constants
  */
 
+#ifndef SW_FACTOR_SEGMENTS
+/* also read by script/incgen-factor to create factor.h */
+
 /* ratio based factors for inductors */
 /* ratio:                                                200   225   250   275   300   325   350   375   400   425   450   475   500   525   550   575   600   625  650  675  700  725  750  775  800  825  850  875  900  925  950  975 */
 const uint16_t Inductor_table[NUM_INDUCTOR] MEM_TYPE = {4481, 3923, 3476, 3110, 2804, 2544, 2321, 2128, 1958, 1807, 1673, 1552, 1443, 1343, 1252, 1169, 1091, 1020, 953, 890, 831, 775, 721, 670, 621, 574, 527, 481, 434, 386, 334, 271};
+#endif
 
 
 /*
@@ -33,6 +37,10 @@ const uint16_t Inductor_table[NUM_INDUCTOR] MEM_TYPE = {4481, 3923, 3476, 3110,
 
 Inductor_Type   Inductor;                /* inductor */
 
+#ifdef SW_INDUCTOR_MULTI
+const unsigned char L_Spread_str[] MEM_TYPE = "dL";
+#endif
+
 
 /*
  *  local defines
@@ -43,6 +51,14 @@ Inductor_Type   Inductor;                /* inductor */
 #define MODE_HIGH_CURRENT     0b00000010     /* high test current */
 #define MODE_DELAYED_START    0b00000100     /* delayed start */
 #define MODE_CHECK_TIME       0b00001000     /* compare time */
+#define MODE_NEXT_SHOT        0b00010000     /* follow-up shot (no discharge) */
+
+/* measurement function */
+#ifdef SW_INDUCTOR_MULTI
+#define MEASURE_INDUCTANCE    MultiInductance     /* multiple shots */
+#else
+#define MEASURE_INDUCTANCE    MeasureInductance   /* single shot */
+#endif
 
 
 /* ************************************************************************
@@ -127,7 +143,11 @@ uint8_t MeasureInductance(uint32_t *Time, uint8_t Mode)
   if (Time == NULL)
     return UINT8_MAX;
 
-  DischargeProbes();                    /* try to discharge probes */
+#ifdef SW_INDUCTOR_MULTI
+  /* follow-up shot: inductor is discharged via Rl after the last one */
+  if (! (Mode & MODE_NEXT_SHOT))
+#endif
+    DischargeProbes();                  /* try to discharge probes */
 
   if (Check.Found == COMP_ERROR)
     return UINT8_MAX;
@@ -165,6 +185,9 @@ uint8_t MeasureInductance(uint32_t *Time, uint8_t Mode)
   ADCSRB = (1 << ACME);                 /* use ADC multiplexer as negative input */
   ADMUX = ADC_REF_BANDGAP | Probes.Ch_2;     /* switch ADC multiplexer to probe-2 */
                                         /* and set AREF to bandgap reference */
+#ifdef ADC_STATE_CACHE
+  ADC_State.Flags &= ~ADC_STATE_VALID;   /* ADC state unknown */
+#endif
   ACSR = (1 << ACBG) | (1 << ACIC);     /* use bandgap as positive input, trigger timer1 */
 #ifndef ADC_LARGE_BUFFER_CAP
     /* buffer cap: 1nF or none at all */
@@ -179,6 +202,10 @@ uint8_t MeasureInductance(uint32_t *Time, uint8_t Mode)
    *  set up timer
    */
 
+#ifdef SW_PROFILER
+  Prof_Pause();                         /* lend Timer1 */
+#endif
+
   Ticks_H = 0;                          /* reset timer overflow counter */
   TCCR1A = 0;                           /* set default mode */
   TCCR1B = 0;                           /* set more timer modes */
@@ -268,6 +295,11 @@ uint8_t MeasureInductance(uint32_t *Time, uint8_t Mode)
     Ticks_H++;                          /* increase overflow counter */
   }
 
+#ifdef SW_PROFILER
+  /* take Timer1 back and add measurement time */
+  Prof_Continue(((uint32_t)Ticks_H << 16) | TCNT1, PROF_MEASURE);
+#endif
+
   /* enable ADC again */
   ADCSRA = (1 << ADEN) | (1 << ADIF) | ADC_CLOCK_DIV;
   ADCSRB &= ~(1 << ACME);               /* disable ADC multiplexer as negative input */
@@ -354,6 +386,117 @@ uint8_t MeasureInductance(uint32_t *Time, uint8_t Mode)
 }
 
 
+#ifdef SW_INDUCTOR_MULTI
+
+/*
+ *  measure inductance via multiple shots
+ *  - discharges probes just for the first shot, the current decays
+ *    via Rl during the stabilization time of the next shot
+ *  - rejects times off by more than 1/8 from the median and averages
+ *    the remaining ones
+ *  - spread of the remaining times is saved in Inductor.Spread
+ *
+ *  requires:
+ *  - pointer to time variable (ns)
+ *  - measurement mode (low/high current, delayed start)
+ *
+ *  returns:
+ *  - 1 if inductance is too low
+ *  - 0 on success
+ *  - UINT8_MAX on any problem
+ */
+
+uint8_t MultiInductance(uint32_t *Time, uint8_t Mode)
+{
+  uint8_t           Ret;           /* return value */
+  uint8_t           n;             /* number of valid shots */
+  uint8_t           i;             /* counter */
+  uint8_t           j;             /* counter */
+  uint32_t          Delay;         /* delay for time check */
+  uint32_t          Shot;          /* time of shot / median */
+  uint32_t          Limit;         /* tolerance */
+  uint32_t          Sum;           /* sum of times */
+  uint32_t          Min;           /* lowest time */
+  uint32_t          Max;           /* highest time */
+  uint32_t          Times[INDUCTOR_SHOTS];   /* sorted times (in ns) */
+
+  Delay = *Time;                   /* save delay */
+
+  /* first shot decides about mode */
+  Ret = MeasureInductance(Time, Mode);
+  if (Ret != 0)
+    return Ret;
+
+  Times[0] = *Time;
+  n = 1;
+
+  /* follow-up shots */
+  for (i = 1; i < INDUCTOR_SHOTS; i++)
+  {
+    Shot = Delay;
+    if (MeasureInductance(&Shot, Mode | MODE_NEXT_SHOT) == 0)
+    {
+      /* insertion sort */
+      j = n;
+      while ((j > 0) && (Times[j - 1] > Shot))
+      {
+        Times[j] = Times[j - 1];
+        j--;
+      }
+      Times[j] = Shot;
+      n++;                         /* one more */
+    }
+  }
+
+  if (n < INDUCTOR_SHOTS / 2)      /* too many failed shots */
+    return UINT8_MAX;
+
+  /*
+   *  reject outliers
+   *  - tolerance: 1/8 of median plus 2 MCU cycles
+   */
+
+  Shot = Times[n / 2];             /* median */
+  Limit = Shot / 8;
+  Limit += 2000 / MCU_CYCLES_PER_US;
+
+  Sum = 0;
+  Min = 0;
+  Max = 0;
+  i = 0;                           /* number of times used */
+  for (j = 0; j < n; j++)
+  {
+    if ((Times[j] + Limit >= Shot) && (Times[j] <= Shot + Limit))
+    {
+      if (i == 0) Min = Times[j];  /* lowest one (sorted) */
+      Max = Times[j];              /* highest one (sorted) */
+      Sum += Times[j];
+      i++;
+    }
+  }
+
+  /* average (median itself is always within tolerance) */
+  Sum += i / 2;                    /* for rounding */
+  Sum /= i;
+  *Time = Sum;
+
+  /* spread (in 0.1%) */
+  Max -= Min;                      /* range */
+  while (Max > 1000000)            /* prevent overflow */
+  {
+    Max /= 10;
+    Sum /= 10;
+  }
+  Max *= 1000;
+  Max /= Sum;
+  Inductor.Spread = (uint16_t)Max;
+
+  return 0;
+}
+
+#endif // SW_INDUCTOR_MULTI
+
+
 /*
  *  measure inductance between two probe pins of a resistor
  *
@@ -383,6 +526,9 @@ uint8_t MeasureInductor(Resistor_Type *Resistor)
   /* reset data */
   Inductor.Scale = 0;
   Inductor.Value = 0;
+#ifdef SW_INDUCTOR_MULTI
+  Inductor.Spread = 0;
+#endif
 
   /* sanity check */
   if (Resistor == NULL)
@@ -408,7 +554,7 @@ uint8_t MeasureInductor(Resistor_Type *Resistor)
    *  - to catch large inductance with capacitive effect
    */
 
-  Test = MeasureInductance(&Time1, MODE_LOW_CURRENT | MODE_DELAYED_START | MODE_CHECK_TIME);
+  Test = MEASURE_INDUCTANCE(&Time1, MODE_LOW_CURRENT | MODE_DELAYED_START | MODE_CHECK_TIME);
   if (Test == UINT8_MAX)         /* no valid measurement yet */
   {
     /*
@@ -416,7 +562,7 @@ uint8_t MeasureInductor(Resistor_Type *Resistor)
      *  - to check for high inductance
      */
 
-    Test = MeasureInductance(&Time1, MODE_LOW_CURRENT);
+    Test = MEASURE_INDUCTANCE(&Time1, MODE_LOW_CURRENT);
     if (Test == 1)             /* inductance too low */
     {
       /*
@@ -428,7 +574,7 @@ uint8_t MeasureInductor(Resistor_Type *Resistor)
       if (CmpValue(Resistor->Value, Resistor->Scale, 40, 0) < 0)
       {
         Scale = 0;             /* high current mode */
-        Test = MeasureInductance(&Time1, MODE_HIGH_CURRENT);
+        Test = MEASURE_INDUCTANCE(&Time1, MODE_HIGH_CURRENT);
       }
     }
   }
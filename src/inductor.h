@@ -24,12 +24,24 @@ typedef struct
 {
   int8_t            Scale;         /* exponent of factor (value * 10^x) */
   unsigned long     Value;         /* inductance */  
+#ifdef SW_INDUCTOR_MULTI
+  uint16_t          Spread;        /* spread of shots (in 0.1%) */
+#endif
 } Inductor_Type;
 
 
+#ifdef SW_INDUCTOR_MULTI
+/* number of shots per measurement */
+#define INDUCTOR_SHOTS        8
+#endif
+
 /* voltage based factors for inductors */
 extern const uint16_t Inductor_table[];
 
+#ifdef SW_INDUCTOR_MULTI
+extern const unsigned char L_Spread_str[];
+#endif
+
 
 extern uint8_t MeasureInductor(Resistor_Type *Resistor);
 
@@ -230,5 +230,19 @@ const unsigned char Hertz_str[] MEM_TYPE = "Hz";
   const unsigned char Diode_LED_str[] MEM_TYPE = "Dioda/LED";
 #endif
 
+#ifdef SW_SAME_AS_LAST
+  const unsigned char Last_Pass_str[] MEM_TYPE = "PASS";
+  const unsigned char Last_Fail_str[] MEM_TYPE = "FAIL";
+  const unsigned char Last_Reset_str[] MEM_TYPE = "Reset reference";
+#endif
+
+#ifdef SW_CAP_DA
+  const unsigned char CapDA_str[] MEM_TYPE = "Cap DA";
+#endif
+
+#ifdef SW_DIODE_IV
+  const unsigned char DiodeIV_str[] MEM_TYPE = "Dioda I-V";
+#endif
+
 
 #endif // UI_POLISH
@@ -238,5 +238,19 @@ const unsigned char Hertz_str[] MEM_TYPE = "
   const unsigned char Meter_5VDC_str[] MEM_TYPE = "5V-";
 #endif
 
+#ifdef SW_SAME_AS_LAST
+  const unsigned char Last_Pass_str[] MEM_TYPE = "";
+  const unsigned char Last_Fail_str[] MEM_TYPE = "";
+  const unsigned char Last_Reset_str[] MEM_TYPE = " ";
+#endif
+
+#ifdef SW_CAP_DA
+  const unsigned char CapDA_str[] MEM_TYPE = " ";
+#endif
+
+#ifdef SW_DIODE_IV
+  const unsigned char DiodeIV_str[] MEM_TYPE = " ";
+#endif
+
 
 #endif // UI_RUSSIAN
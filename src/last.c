@@ -0,0 +1,440 @@
+/* ************************************************************************
+ *
+ *   same-as-last mode
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+/*
+ *  hints:
+ *  - for sorting or verifying many parts of the same type
+ *  - a full probing cycle remembers the result and the probe
+ *    permutations and MeasureCap() runs which added to it
+ *  - the next cycle runs just those (verification run) and compares
+ *    the result with the last one
+ *  - on a mismatch the probing cycle is restarted with a full run,
+ *    which confirms the mismatch (FAIL) or finds the reference again
+ *  - the reference is kept until it's reset via the main menu
+ */
+
+
+/*
+ *  include header files
+ */
+
+/* local includes */
+#include "common.h"                /* common header file */
+
+
+#ifdef SW_SAME_AS_LAST
+
+/*
+ *  local variables
+ */
+
+/* same-as-last state */
+Last_Type              Last;
+
+
+
+/* ************************************************************************
+ *   tracking
+ * ************************************************************************ */
+
+/*
+ *  get bit for a probe permutation
+ *  - one bit per ordered probe pair (probe-3 is the remaining one)
+ *
+ *  requires:
+ *  - Probe1: ID of probe #1
+ *  - Probe2: ID of probe #2
+ *
+ *  returns:
+ *  - bit mask
+ */
+
+uint8_t Last_PermBit(uint8_t Probe1, uint8_t Probe2)
+{
+  uint8_t           n;             /* bit number */
+
+  n = Probe1 * 2;                  /* two pairs per probe-1 */
+  if (Probe2 > Probe1) Probe2--;   /* skip probe-1 */
+  n += Probe2;
+
+  return (1 << n);
+}
+
+
+/*
+ *  get state of detection
+ *
+ *  returns:
+ *  - state packed into 32 bits
+ */
+
+uint32_t Last_State(void)
+{
+  uint32_t          State;
+
+  State = Check.AltFound;
+  State <<= 8;
+  State |= (Check.Diodes << 4) | Check.Resistors;
+  State <<= 8;
+  State |= Check.Done;
+  State <<= 8;
+  State |= Check.Found;
+
+  return State;
+}
+
+
+/*
+ *  save state before CheckProbes() checks a permutation
+ */
+
+void Last_Mark(void)
+{
+  Last.Mark = Last_State();
+}
+
+
+/*
+ *  remember permutation if CheckProbes() added something
+ *
+ *  requires:
+ *  - Probe1: ID of probe #1
+ *  - Probe2: ID of probe #2
+ */
+
+void Last_Track(uint8_t Probe1, uint8_t Probe2)
+{
+  if (Last_State() != Last.Mark)   /* state changed */
+    Last.Track |= Last_PermBit(Probe1, Probe2);
+}
+
+
+
+/* ************************************************************************
+ *   probing
+ * ************************************************************************ */
+
+/*
+ *  check probe permutations
+ *  - replaces the 6 CheckProbes() calls
+ *  - verification run: permutations of last part only
+ *  - otherwise: all permutations
+ */
+
+void Last_CheckProbes(void)
+{
+  uint8_t           Mask;          /* permutations to check */
+  uint8_t           n;             /* counter */
+  uint8_t           Perm;          /* permutation */
+  uint8_t           Probe1;        /* ID of probe #1 */
+  uint8_t           Probe2;        /* ID of probe #2 */
+  uint8_t           Probe3;        /* ID of probe #3 */
+
+  Last.Track = 0;                  /* reset permutations */
+  Last.Flags &= ~LAST_FAST;        /* reset run mode */
+
+  if ((Last.Flags & (LAST_VALID | LAST_FULL)) == LAST_VALID)
+  {
+    /* got last part and no mismatch to confirm */
+    Last.Flags |= LAST_FAST;       /* verification run */
+    Mask = Last.Perms;             /* just the required ones */
+  }
+  else                             /* full run */
+  {
+#ifdef SW_PROBE_SCHEDULER
+    CheckAllProbes();              /* required combinations only */
+    return;
+#else
+    Mask = 0b00111111;             /* all permutations */
+#endif
+  }
+
+  for (n = 0; n < 6; n++)
+  {
+    /* get probe IDs */
+    Perm = DATA_read_byte(&Permutation_table[n]);
+    Probe1 = (Perm >> 4) & 0b00000011;
+    Probe2 = (Perm >> 2) & 0b00000011;
+    Probe3 = Perm & 0b00000011;
+
+    if (Mask & Last_PermBit(Probe1, Probe2))
+      CheckProbes(Probe1, Probe2, Probe3);
+  }
+}
+
+
+/*
+ *  measure capacitance
+ *  - replaces the 3 MeasureCap() calls
+ *  - verification run: probe pairs of last part only
+ */
+
+void Last_MeasureCaps(void)
+{
+  Capacitor_Type    *Cap;          /* pointer to cap */
+  uint8_t           Mask;          /* probe pairs to check */
+  uint8_t           n;             /* counter */
+
+  if (Last.Flags & LAST_FAST)      /* verification run */
+    Mask = Last.Caps;              /* just the required ones */
+  else                             /* full run */
+    Mask = 0b00000111;             /* all probe pairs */
+
+#ifdef SW_CAP_SCAN
+  MeasureCaps(Mask);               /* skips open pairs */
+#else
+  if (Mask & 0b00000001) MeasureCap(PROBE_3, PROBE_1, 0);
+  if (Mask & 0b00000010) MeasureCap(PROBE_3, PROBE_2, 1);
+  if (Mask & 0b00000100) MeasureCap(PROBE_2, PROBE_1, 2);
+#endif
+
+  /* clear results of skipped pairs and remember cap pairs */
+  Last.Caps = 0;
+  Cap = &Caps[0];
+  for (n = 0; n < 3; n++)
+  {
+    if (! (Mask & (1 << n)))       /* skipped */
+    {
+      Cap->A = 0;
+      Cap->B = 0;
+      Cap->Scale = -12;
+      Cap->Value = 0;
+    }
+
+    if (Cap->A != Cap->B)          /* got a cap */
+      Last.Caps |= (1 << n);
+
+    Cap++;                         /* next one */
+  }
+}
+
+
+
+/* ************************************************************************
+ *   verification
+ * ************************************************************************ */
+
+/*
+ *  get key data of current result
+ *  - key value: R, C, V_f, hFE, V_th or V_GS(off), V_GT
+ *  - PUT, UJT and Zener: type and pinout only
+ *
+ *  requires:
+ *  - Part: pointer to key data
+ */
+
+void Last_GetPart(Last_Part_Type *Part)
+{
+  Capacitor_Type    *Cap;          /* pointer to cap */
+  uint8_t           n;             /* counter */
+  int16_t           U;             /* voltage */
+
+  Part->Found = Check.Found;
+  Part->Type = Check.Type;
+  Part->Diodes = Check.Diodes;
+  Part->Resistors = Check.Resistors;
+  Part->A = Semi.A;
+  Part->B = Semi.B;
+  Part->C = Semi.C;
+  Part->Scale = 0;
+  Part->Value = 0;
+
+  switch (Check.Found)
+  {
+    case COMP_RESISTOR:       /* first resistor */
+      Part->A = Resistors[0].A;
+      Part->B = Resistors[0].B;
+      Part->C = 0;
+      Part->Scale = Resistors[0].Scale;
+      Part->Value = Resistors[0].Value;
+      break;
+
+    case COMP_CAPACITOR:      /* first cap */
+      Cap = &Caps[0];
+      n = 0;
+      while ((n < 2) && (Cap->A == Cap->B))
+      {
+        n++;                       /* next one */
+        Cap++;
+      }
+      Part->A = Cap->A;
+      Part->B = Cap->B;
+      Part->C = 0;
+      Part->Scale = Cap->Scale;
+      Part->Value = Cap->Value;
+      break;
+
+    case COMP_DIODE:          /* first diode: V_f */
+      Part->A = Diodes[0].A;
+      Part->B = Diodes[0].C;
+      Part->C = 0;
+      Part->Scale = -3;
+      Part->Value = Diodes[0].V_f;
+      break;
+
+    case COMP_BJT:            /* hFE */
+      Part->Value = Semi.F_1;
+      break;
+
+    case COMP_FET:            /* V_th or V_GS(off) */
+    case COMP_IGBT:           /* V_th */
+      U = Semi.U_2;                /* V_th */
+      if (U == 0) U = Semi.U_3;    /* V_GS(off) of depletion mode FET */
+      if (U < 0) U = -U;           /* P-channel: magnitude */
+      Part->Scale = -3;
+      Part->Value = U;
+      break;
+
+    case COMP_THYRISTOR:      /* V_GT */
+    case COMP_TRIAC:
+      Part->Scale = -3;
+      Part->Value = Semi.U_1;
+      break;
+  }
+}
+
+
+/*
+ *  check if value is within tolerance of last part
+ *
+ *  requires:
+ *  - Value: value
+ *  - Scale: exponent of value
+ *
+ *  returns:
+ *  - 1 if within tolerance
+ *  - 0 if not
+ */
+
+uint8_t Last_CmpValue(uint32_t Value, int8_t Scale)
+{
+  uint32_t          Delta;         /* tolerance */
+
+  Delta = Last.Part.Value / (100 / LAST_TOLERANCE);
+
+  if (CmpValue(Value, Scale, Last.Part.Value - Delta, Last.Part.Scale) == -1)
+    return 0;                      /* too low */
+
+  if (CmpValue(Value, Scale, Last.Part.Value + Delta, Last.Part.Scale) == 1)
+    return 0;                      /* too high */
+
+  return 1;
+}
+
+
+/*
+ *  compare key data with last part
+ *
+ *  requires:
+ *  - Part: pointer to key data
+ *
+ *  returns:
+ *  - 1 if same part
+ *  - 0 if not
+ */
+
+uint8_t Last_CmpPart(Last_Part_Type *Part)
+{
+  if ((Part->Found == Last.Part.Found) &&
+      (Part->Type == Last.Part.Type) &&
+      (Part->Diodes == Last.Part.Diodes) &&
+      (Part->Resistors == Last.Part.Resistors) &&
+      (Part->A == Last.Part.A) &&
+      (Part->B == Last.Part.B) &&
+      (Part->C == Last.Part.C) &&
+      ((Last.Part.Value == 0) || Last_CmpValue(Part->Value, Part->Scale)))
+    return 1;
+
+  return 0;
+}
+
+
+/*
+ *  verify result against last part or save first part as reference
+ *  - call after probing and before displaying the result
+ *  - a mismatch of a verification run is confirmed by a full run
+ *  - the reference is kept on a mismatch and for an empty socket
+ *
+ *  returns:
+ *  - 1 to display result
+ *  - 0 for mismatch (restart probing cycle with full run)
+ */
+
+uint8_t Last_Verify(void)
+{
+  Last_Part_Type    Part;          /* key data of current part */
+
+  Last_GetPart(&Part);             /* get key data */
+
+  if (! (Last.Flags & LAST_VALID))      /* no reference yet */
+  {
+    if ((Check.Found != COMP_NONE) && (Check.Found != COMP_ERROR))
+    {
+      /* first part: new reference */
+      Last.Part = Part;                 /* save key data */
+      Last.Perms = Last.Track;          /* save permutations */
+      Last.Flags = LAST_VALID;
+    }
+
+    return 1;
+  }
+
+  if (Last_CmpPart(&Part))              /* same part */
+  {
+    Last.Flags = LAST_VALID | LAST_PASS;
+    return 1;
+  }
+
+  if (Last.Flags & LAST_FAST)           /* verification run */
+  {
+    /* mismatch: confirm with full run */
+    Last.Flags = LAST_VALID | LAST_FULL;
+    return 0;
+  }
+
+  /* full run */
+  if ((Check.Found == COMP_NONE) || (Check.Found == COMP_ERROR))
+    Last.Flags = LAST_VALID;            /* empty socket: no signal */
+  else                                  /* different part */
+    Last.Flags = LAST_VALID | LAST_FAIL;
+
+  return 1;
+}
+
+
+/*
+ *  reset reference
+ *  - next part found becomes the new reference
+ */
+
+void Last_Reset(void)
+{
+  Last.Flags = 0;                       /* no reference */
+}
+
+
+/*
+ *  display pass/fail signal
+ *  - call before displaying the result, so that the signal is put
+ *    in front of the part type in line #1 (kept when paging)
+ *  - PASS: same part as last one
+ *  - FAIL: different part
+ */
+
+void Last_Show(void)
+{
+  if (Last.Flags & LAST_PASS)           /* same part */
+    Display_EEString_Space(Last_Pass_str);   /* display: PASS */
+  else if (Last.Flags & LAST_FAIL)      /* different part */
+    Display_EEString_Space(Last_Fail_str);   /* display: FAIL */
+
+  Last.Flags &= ~(LAST_PASS | LAST_FAIL);    /* signal once */
+}
+
+
+#endif // SW_SAME_AS_LAST
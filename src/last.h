@@ -0,0 +1,68 @@
+/* ************************************************************************
+ *
+ *   same-as-last mode
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+#ifndef LAST_H
+#define LAST_H
+
+
+#ifdef SW_SAME_AS_LAST
+
+/* mode flags (Last_Type.Flags) */
+#define LAST_VALID            0b00000001     /* got result of last part */
+#define LAST_FAST             0b00000010     /* verification run */
+#define LAST_PASS             0b00000100     /* same part as last one */
+#define LAST_FAIL             0b00001000     /* different part */
+#define LAST_FULL             0b00010000     /* full run after mismatch */
+
+
+/* key data of a probing result */
+typedef struct
+{
+  uint8_t           Found;         /* component type */
+  uint8_t           Type;          /* component specific subtype */
+  uint8_t           Diodes;        /* number of diodes */
+  uint8_t           Resistors;     /* number of resistors */
+  uint8_t           A;             /* probe ID of pin A */
+  uint8_t           B;             /* probe ID of pin B */
+  uint8_t           C;             /* probe ID of pin C */
+  int8_t            Scale;         /* exponent of key value (10^x) */
+  uint32_t          Value;         /* key value (0 = none) */
+} Last_Part_Type;
+
+/* same-as-last state */
+typedef struct
+{
+  Last_Part_Type    Part;          /* last part */
+  uint32_t          Mark;          /* state before CheckProbes() */
+  uint8_t           Perms;         /* permutations adding to result */
+  uint8_t           Track;         /* permutations of current run */
+  uint8_t           Caps;          /* MeasureCap() runs finding a cap */
+  uint8_t           Flags;         /* mode flags */
+} Last_Type;
+
+extern Last_Type    Last;
+
+extern const unsigned char Last_Pass_str[];
+extern const unsigned char Last_Fail_str[];
+extern const unsigned char Last_Reset_str[];
+
+
+extern uint8_t Last_PermBit(uint8_t Probe1, uint8_t Probe2);
+extern void Last_Mark(void);
+extern void Last_Track(uint8_t Probe1, uint8_t Probe2);
+extern void Last_CheckProbes(void);
+extern void Last_MeasureCaps(void);
+extern uint8_t Last_Verify(void);
+extern void Last_Reset(void);
+extern void Last_Show(void);
+
+
+#endif // SW_SAME_AS_LAST
+
+
+#endif // LAST_H
@@ -46,6 +46,10 @@ const unsigned char I_DSS_str[] MEM_TYPE = "Idss";
 const unsigned char I_leak_str[] MEM_TYPE = "I_l";
 const unsigned char R_DS_str[] MEM_TYPE = "Rds";
 const unsigned char V_GSoff_str[] MEM_TYPE = "V_GS(off)";
+#ifdef SW_HFE_SWEEP
+const unsigned char hFE_Points_str[] MEM_TYPE = "points";
+const unsigned char hFE_Few_str[] MEM_TYPE = "too few";
+#endif
 
 /* component symbols */
 const unsigned char Cap_str[] MEM_TYPE = {'-', LCD_CHAR_CAP, '-',0};
@@ -211,7 +215,8 @@ void Show_ENormValues(uint32_t Value, int8_t Scale, uint8_t ESeries, uint8_t Tol
 
   if (Temp < 10)                        /* < 1% */
     Pos = 1;                            /* one decimal place */
-  Temp /= 10;                           /* scale to 1 */
+  else
+    Temp /= 10;                         /* scale to 1 */
 
   Display_FullValue(Temp, Pos, '%');    /* display tolerance */
   Display_Space();                      /* display: " " */
@@ -704,6 +709,12 @@ void Show_Resistor(void)
       Display_Space();
       Display_Value(Inductor.Value, Inductor.Scale, 'H');
 
+#ifdef SW_INDUCTOR_MULTI
+      /* display spread of shots in % */
+      Display_NL_EEString_Space(L_Spread_str);
+      Display_Value(Inductor.Spread, -1, '%');   /* in 0.1% */
+#endif
+
 #ifdef UI_SERIAL_COMMANDS
       /* set data for remote commands */
       Info.Flags |= INFO_R_L;      /* inductance measured */
@@ -742,6 +753,11 @@ void Show_Resistor(void)
       Show_ENormCodes(R1->Value, R1->Scale, E24, 10, COLOR_CODE_BROWN);
 #endif
 
+#ifdef SW_R_E48_T
+      /* show E series norm values for E48 2% */
+      Show_ENormValues(R1->Value, R1->Scale, E48, 20, LCD_CHAR_OMEGA);
+#endif
+
 #ifdef SW_R_E96_T
       /* show E series norm values for E96 1% */
       Show_ENormValues(R1->Value, R1->Scale, E96, 10, LCD_CHAR_OMEGA);
@@ -756,6 +772,11 @@ void Show_Resistor(void)
       /* show E series norm value EIA-96 codes for E96 1% */
       Show_ENormEIA96(R1->Value, R1->Scale);
 #endif
+
+#ifdef SW_R_E192_T
+      /* show E series norm values for E192 0.5% */
+      Show_ENormValues(R1->Value, R1->Scale, E192, 5, LCD_CHAR_OMEGA);
+#endif
     }
 #endif // SW_R_EXX
   }
@@ -782,6 +803,11 @@ void Show_Resistor(void)
     Show_ENormCodes(R1->Value, R1->Scale, E24, 10, COLOR_CODE_BROWN);
 #endif
 
+#ifdef SW_R_E48_T
+    /* show E series norm values for E48 2% */
+    Show_ENormValues(R1->Value, R1->Scale, E48, 20, LCD_CHAR_OMEGA);
+#endif
+
 #ifdef SW_R_E96_T
     /* show E series norm values for E96 1% */
     Show_ENormValues(R1->Value, R1->Scale, E96, 10, LCD_CHAR_OMEGA);
@@ -796,6 +822,11 @@ void Show_Resistor(void)
     /* show E series norm value EIA-96 codes for E96 1% */
     Show_ENormEIA96(R1->Value, R1->Scale);
 #endif
+
+#ifdef SW_R_E192_T
+    /* show E series norm values for E192 0.5% */
+    Show_ENormValues(R1->Value, R1->Scale, E192, 5, LCD_CHAR_OMEGA);
+#endif
   }
 #endif // SW_INDUCTOR
 }
@@ -913,10 +944,29 @@ void Show_Capacitor(void)
 
 void Show_SemiCurrent(const unsigned char *String)
 {
+#ifdef SW_LEAK_RANGING
+  /* show if >= 1nA and above uncertainty */
+  if ((CmpValue(Semi.I_value, Semi.I_scale, 1, -9) >= 0) &&
+      (Semi.I_value > Semi.I_error))
+#else
   if (CmpValue(Semi.I_value, Semi.I_scale, 10, -9) >= 0)  /* show if >= 10nA */
+#endif
   {
     Display_NL_EEString_Space(String);               /* display: <string> */
     Display_Value(Semi.I_value, Semi.I_scale, 'A');  /* display current */
+
+#if defined (SW_LEAK_RANGING) && defined (UI_SERIAL_COPY)
+    if (Semi.I_error > 0)                            /* got uncertainty */
+    {
+      /* uncertainty (serial only) */
+      Cfg.OP_Control &= ~OP_OUT_LCD;                 /* disable display output */
+      Display_Space();
+      Display_Char('+');                             /* display: +- */
+      Display_Char('-');
+      Display_Value(Semi.I_error, Semi.I_scale, 'A');     /* display uncertainty */
+      Cfg.OP_Control |= OP_OUT_LCD;                  /* enable display output */
+    }
+#endif
   }
 }
 
@@ -1234,6 +1284,61 @@ void Show_Diode(void)
 }
 
 
+#ifdef SW_HFE_SWEEP
+
+/*
+ *  show hFE sweep of BJT
+ *  - points measured by Get_hFE_Sweep() while probing
+ *  - table via serial only (one line per point):
+ *    I_C/I_E, I_B, hFE and test circuit type
+ *  - number of points, with a notice when less than
+ *    HFE_SWEEP_MIN_POINTS distinct points were found
+ *  - requires serial output to be enabled
+ */
+
+void Show_hFE_Sweep(void)
+{
+  hFE_Point_Type    *Point;        /* pointer to point */
+  uint8_t           Num;           /* number of points */
+
+  Cfg.OP_Control &= ~OP_OUT_LCD;   /* disable display output */
+
+  /* number of points */
+  Num = hFE_Count;
+  Serial_NewLine();                          /* serial: new line */
+  Display_EEString_Space(hFE_Points_str);    /* display: points */
+  Display_Value2(Num);                       /* display number */
+  if (Num < HFE_SWEEP_MIN_POINTS)            /* too few points */
+  {
+    Display_Space();
+    Display_EEString(hFE_Few_str);           /* display: too few */
+  }
+
+  Point = &hFE_Points[0];
+  while (Num > 0)
+  {
+    Serial_NewLine();                        /* serial: new line */
+    Display_Value(Point->I_x, -9, 'A');      /* display I_C/I_E */
+    Display_Space();
+    Display_Value(Point->I_b, -9, 'A');      /* display I_B */
+    Display_Space();
+    Display_Value2(Point->hFE);              /* display hFE */
+    Display_Space();
+    if (Point->Mode & HFE_SWEEP_CC)          /* common collector */
+      Display_Char('c');                     /* display: c */
+    else                                     /* common emitter */
+      Display_Char('e');                     /* display: e */
+
+    Point++;                                 /* next one */
+    Num--;
+  }
+
+  Cfg.OP_Control |= OP_OUT_LCD;    /* enable display output */
+}
+
+#endif
+
+
 /*
  *  show BJT
  */
@@ -1534,6 +1639,14 @@ void Show_BJT(void)
     }
   }
 #endif // SW_SCHOTTKY_BJT
+
+#ifdef SW_HFE_SWEEP
+  /*
+   *  hFE sweep
+   */
+
+  Show_hFE_Sweep();                     /* table via serial */
+#endif
 }
 
 
@@ -1627,6 +1740,15 @@ void Show_FET_Extras(void)
       Display_NL_EEString_Space(Vth_str);         /* display: Vth */
       Display_SignedValue(Semi.U_2, -3, 'V');     /* display V_th in mV */
 
+#if defined (SW_VTH_TRACKING) && defined (UI_SERIAL_COPY)
+      /* number of samples (serial only) */
+      Cfg.OP_Control &= ~OP_OUT_LCD;              /* disable display output */
+      Display_Space();
+      Display_Value2(Semi.Runs);                  /* display number */
+      Display_Char('x');                          /* display: x */
+      Cfg.OP_Control |= OP_OUT_LCD;               /* enable display output */
+#endif
+
 #ifdef UI_SERIAL_COMMANDS
       /* set data for remote commands */
       Info.Flags |= INFO_FET_V_TH;                /* measured Vth */
@@ -2010,6 +2132,10 @@ void CheckVoltageRefs(void)
   uint32_t          Temp;          /* temporary value */
 #endif
 
+#ifdef ADC_ADAPTIVE
+  Cfg.Tolerance = 0;               /* take all samples */
+#endif
+
   /*
    *  external 2.5V voltage reference
    */
@@ -2042,6 +2168,9 @@ void CheckVoltageRefs(void)
 
   /* clean up */
   Cfg.Samples = ADC_SAMPLES;            /* set ADC samples back to default */
+#ifdef ADC_ADAPTIVE
+  Cfg.Tolerance = ADC_TOLERANCE;        /* set tolerance back to default */
+#endif
 }
 
 
@@ -2381,7 +2510,11 @@ int main(void)
 
 #if defined(SPI_BITBANG) || defined(SPI_HARDWARE)
   /* hardware or bitbang SPI */
+#ifdef SPI_HARDWARE
+  SPI_Setup(0);                         /* set up SPI bus, clock rate set by display driver */
+#else
   SPI_Setup();                          /* set up SPI bus */
+#endif
 #endif
 
   /* display module */
@@ -2638,6 +2771,9 @@ int main(void)
 
   /* default offsets and values */
   Cfg.Samples = ADC_SAMPLES;            /* number of ADC samples */
+#ifdef ADC_ADAPTIVE
+  Cfg.Tolerance = ADC_TOLERANCE;        /* standard error for early termination */
+#endif
   Cfg.AutoScale = 1;                    /* enable ADC auto scaling */
   Cfg.Ref = 1;                          /* no ADC reference set yet */
   Cfg.Vcc = UREF_VCC;                   /* voltage of Vcc */
@@ -2687,6 +2823,10 @@ int main(void)
 
 cycle_start:
 
+#ifdef SW_PROFILER
+  Prof_Start();                    /* start profiling this cycle */
+#endif
+
   /* reset variables */
   Check.Found = COMP_NONE;         /* no component */
   Check.Type = 0;                  /* reset type flags */
@@ -2694,6 +2834,11 @@ cycle_start:
   Check.AltFound = COMP_NONE;      /* no alternative component */
   Check.Diodes = 0;                /* reset diode counter */
   Check.Resistors = 0;             /* reset resistor counter */
+#ifdef SW_DISCHARGE_MODEL
+  Check.Tau[0] = 0;                /* reset time constants */
+  Check.Tau[1] = 0;
+  Check.Tau[2] = 0;
+#endif
   Semi.Flags = 0;                  /* reset flags */
   Semi.U_1 = 0;                    /* reset values */
   Semi.U_2 = 0;
@@ -2703,6 +2848,9 @@ cycle_start:
   Semi.F_2 = 0;
 #endif
   Semi.I_value = 0;
+#ifdef SW_LEAK_RANGING
+  Semi.I_error = 0;
+#endif
   AltSemi.U_1 = 0;
   AltSemi.U_2 = 0;
 #ifdef UI_SERIAL_COMMANDS
@@ -2790,7 +2938,13 @@ cycle_start:
 #endif
 
   /* try to discharge any connected component */
+#ifdef SW_PROFILER
+  Prof_Enter(PROF_DISCHARGE);
+#endif
   DischargeProbes();
+#ifdef SW_PROFILER
+  Prof_Leave();
+#endif
   if (Check.Found == COMP_ERROR)   /* discharge failed */
     goto show_component;           /* skip all other checks */
 
@@ -2798,20 +2952,38 @@ cycle_start:
   /* enter main menu if requested by short-circuiting all probes */
   if (ShortedProbes() == 3)        /* all probes short-circuited */
   {
+#ifdef SW_PROFILER
+    Prof_Stop();                   /* no report */
+#endif
     Key = KEY_MAINMENU;            /* trigger main menu */
     goto cycle_action;             /* perform action */
   }
 #endif
 
   /* check all 6 combinations of the 3 probes */
+#ifdef SW_PROFILER
+  Prof_Enter(PROF_CHECK);
+#endif
+#if defined (SW_SAME_AS_LAST)
+  Last_CheckProbes();              /* last part's combinations or all */
+#elif defined (SW_PROBE_SCHEDULER)
+  CheckAllProbes();                /* required combinations only */
+#else
   CheckProbes(PROBE_1, PROBE_2, PROBE_3);
   CheckProbes(PROBE_2, PROBE_1, PROBE_3);
   CheckProbes(PROBE_1, PROBE_3, PROBE_2);
   CheckProbes(PROBE_3, PROBE_1, PROBE_2);
   CheckProbes(PROBE_2, PROBE_3, PROBE_1);
   CheckProbes(PROBE_3, PROBE_2, PROBE_1);
+#endif
 
+#ifdef SW_PROFILER
+  Prof_Enter(PROF_ALTERNATIVES);
+#endif
   CheckAlternatives();             /* process alternatives */
+#ifdef SW_PROFILER
+  Prof_Leave();
+#endif
   SemiPinDesignators();            /* manage semi pin designators */
 
   /* if component might be a capacitor */
@@ -2824,9 +2996,21 @@ cycle_start:
     Display_Char('C');
 
     /* check all possible combinations */
+#ifdef SW_PROFILER
+    Prof_Enter(PROF_CAP);
+#endif
+#if defined (SW_SAME_AS_LAST)
+    Last_MeasureCaps();            /* last part's pairs or all */
+#elif defined (SW_CAP_SCAN)
+    MeasureCaps(0b00000111);       /* all pairs, skip open ones */
+#else
     MeasureCap(PROBE_3, PROBE_1, 0);
     MeasureCap(PROBE_3, PROBE_2, 1);
     MeasureCap(PROBE_2, PROBE_1, 2);
+#endif
+#ifdef SW_PROFILER
+    Prof_Leave();
+#endif
   }
 
 #ifdef HW_PROBE_ZENER
@@ -2835,12 +3019,28 @@ cycle_start:
     CheckZener();
 #endif
 
+#ifdef SW_SAME_AS_LAST
+  /* compare with last part */
+  if (Last_Verify() == 0)          /* different part */
+    goto cycle_start;              /* run full probing cycle */
+#endif
+
+#ifdef SW_HFE_SWEEP
+  /* BJT: measure hFE at several operating points */
+  if (Check.Found == COMP_BJT)
+    Get_hFE_Sweep();
+#endif
+
   /*
    *  output test results
    */
 
 show_component:
 
+#ifdef SW_PROFILER
+  Prof_Enter(PROF_SHOW);
+#endif
+
   LCD_Clear();                     /* clear LCD */
 
   /* next-line mode */
@@ -2882,6 +3082,11 @@ show_component:
     Cfg.OP_Mode |= OP_AUTOHOLD_TEMP | OP_AUTOHOLD;
 #endif
 
+#ifdef SW_SAME_AS_LAST
+  /* pass/fail signal in front of part type (line #1) */
+  Last_Show();                     /* display pass/fail */
+#endif
+
   /* call output function based on component type */
   switch (Check.Found)
   {
@@ -2982,6 +3187,10 @@ show_component:
     MissedParts = 0;          /* reset counter */
 #endif
 
+#ifdef SW_PROFILER
+  Prof_Report();                   /* output stage times */
+#endif
+
   /*
    *  manage cycling and power-off
    */
@@ -92,6 +92,11 @@ void MilliSleep(uint16_t Time)
   }
 #endif // SAVE_POWER
 
+#ifdef SW_PROFILER
+  /* Timer1 doesn't run in power save mode */
+  Prof_Pause();                    /* pause profiler */
+#endif
+
   /*
    *  set up timer
    */
@@ -105,10 +110,11 @@ void MilliSleep(uint16_t Time)
   set_sleep_mode(Mode);            /* set sleep mode */
 #endif
 
-  if (SREG & (1 << SREG_I))        /* if interrupts are already enabled */
-    Clean = 1;                      /* keep that in mind */
-  else                             /* otherwise */
+  if (! (SREG & (1 << SREG_I)))    /* if interrupts are disabled */
+  {
     sei();                         /* enable interrupts */
+    Clean = 1;                     /* keep that in mind */
+  }
 
   /*
    *  processing loop
@@ -161,8 +167,18 @@ void MilliSleep(uint16_t Time)
     }
   }
 
+#ifdef ADC_STATE_CACHE
+  /* ADC hasn't run for a while */
+  ADC_State.Flags &= ~ADC_STATE_VALID;
+#endif
+
   if (Clean != 0)             /* restore former interrupt setting */
     cli();                    /* disable interrupts */
+
+#ifdef SW_PROFILER
+  /* add nominal sleep time (ms * 1024 * MCU cycles per s) */
+  Prof_Continue((uint32_t)Time * 1024 * MCU_CYCLES_PER_US, PROF_SLEEP);
+#endif
 }
 
 
@@ -14,6 +14,9 @@
 
 /* local includes */
 #include "common.h"                /* common header file */
+#ifdef SW_FACTOR_SEGMENTS
+#include "factor.h"                /* segments (script/incgen-factor) */
+#endif
 
 
 /*
@@ -39,6 +42,34 @@ const uint8_t Pin_table[] MEM_TYPE = {(1 << TP1), (1 << TP2), (1 << TP3)};
 /* register bits for ADC MUX input channels based on probe ID (ADC0-7 only) */
 const uint8_t Channel_table[] MEM_TYPE = {TP1, TP2, TP3};
 
+#ifdef SW_FACTOR_SEGMENTS
+/* fixed-point segments for factors (intercept, slope) */
+const uint16_t SmallCap_seg[] MEM_TYPE = {FACTOR_SMALL_CAP_SEGMENTS};
+const uint16_t LargeCap_seg[] MEM_TYPE = {FACTOR_LARGE_CAP_SEGMENTS};
+#ifdef SW_INDUCTOR
+const uint16_t Inductor_seg[] MEM_TYPE = {FACTOR_INDUCTOR_SEGMENTS};
+#endif
+#endif
+
+#if defined (SW_PROBE_SCHEDULER) || defined (SW_SAME_AS_LAST)
+/*
+ *  probe permutations for CheckAllProbes() and Last_CheckProbes()
+ *  - probe-1: bits 4-5, probe-2: bits 2-3, probe-3: bits 0-1
+ *  - grouped by probe-3 (base/gate), most likely first:
+ *    two-terminal parts are usually connected to probes #1 and #2,
+ *    the base/gate of TO-92 parts is usually the center pin
+ *  - both directions of a probe pair are next to each other,
+ *    the second one is the verification run of the first one
+ */
+
+#define PERMUTATION(P1, P2, P3)    (((P1) << 4) | ((P2) << 2) | (P3))
+
+const uint8_t Permutation_table[] MEM_TYPE = {
+  PERMUTATION(PROBE_1, PROBE_2, PROBE_3), PERMUTATION(PROBE_2, PROBE_1, PROBE_3),
+  PERMUTATION(PROBE_1, PROBE_3, PROBE_2), PERMUTATION(PROBE_3, PROBE_1, PROBE_2),
+  PERMUTATION(PROBE_2, PROBE_3, PROBE_1), PERMUTATION(PROBE_3, PROBE_2, PROBE_1)};
+#endif
+
 #ifdef SW_E6
 /* E6 (in 0.01) */
 const uint16_t E6_table[NUM_E6] MEM_TYPE = {100, 150, 220, 330, 470, 680};  
@@ -54,8 +85,8 @@ const uint16_t E12_table[NUM_E12] MEM_TYPE = {100, 120, 150, 180, 220, 270, 330,
 const uint16_t E24_table[NUM_E24] MEM_TYPE = {100, 110, 120, 130, 150, 160, 180, 200, 220, 240, 270, 300, 330, 360, 390, 430, 470, 510, 560, 620, 680, 750, 820, 910};
 #endif
 
-#ifdef SW_E96
-/* E96 (in 0.01) */
+#if (defined (SW_E48) || defined (SW_E96)) && !defined (SW_E192)
+/* E96 (in 0.01), also E48 (every 2nd value) */
 const uint16_t E96_table[NUM_E96] MEM_TYPE = {
   100, 102, 105, 107, 110, 113, 115, 118, 121, 124, 127, 130, 133, 137, 140, 143, 147, 150, 154, 158, 162, 165, 169, 174,
   178, 182, 187, 191, 196, 200, 205, 210, 215, 221, 226, 232, 237, 243, 249, 255, 261, 267, 274, 280, 287, 294, 301, 309,
@@ -63,6 +94,19 @@ const uint16_t E96_table[NUM_E96] MEM_TYPE = {
   562, 576, 590, 604, 619, 634, 649, 665, 681, 698, 715, 732, 750, 768, 787, 806, 825, 845, 866, 887, 909, 931, 953, 976}; 
 #endif
 
+#ifdef SW_E192
+/* E192 (in 0.01), also E96 (every 2nd value) and E48 (every 4th value) */
+const uint16_t E192_table[NUM_E192] MEM_TYPE = {
+  100, 101, 102, 104, 105, 106, 107, 109, 110, 111, 113, 114, 115, 117, 118, 120, 121, 123, 124, 126, 127, 129, 130, 132,
+  133, 135, 137, 138, 140, 142, 143, 145, 147, 149, 150, 152, 154, 156, 158, 160, 162, 164, 165, 167, 169, 172, 174, 176,
+  178, 180, 182, 184, 187, 189, 191, 193, 196, 198, 200, 203, 205, 208, 210, 213, 215, 218, 221, 223, 226, 229, 232, 234,
+  237, 240, 243, 246, 249, 252, 255, 258, 261, 264, 267, 271, 274, 277, 280, 284, 287, 291, 294, 298, 301, 305, 309, 312,
+  316, 320, 324, 328, 332, 336, 340, 344, 348, 352, 357, 361, 365, 370, 374, 379, 383, 388, 392, 397, 402, 407, 412, 417,
+  422, 427, 432, 437, 442, 448, 453, 459, 464, 470, 475, 481, 487, 493, 499, 505, 511, 517, 523, 530, 536, 542, 549, 556,
+  562, 569, 576, 583, 590, 597, 604, 612, 619, 626, 634, 642, 649, 657, 665, 673, 681, 690, 698, 706, 715, 723, 732, 741,
+  750, 759, 768, 777, 787, 796, 806, 816, 825, 835, 845, 856, 866, 876, 887, 898, 909, 920, 931, 942, 953, 965, 976, 988};
+#endif
+
 
 /*
  *  local variables
@@ -86,6 +130,11 @@ Probe_Type        Probes;                  /* test probes */
 
 void UpdateProbes(uint8_t Probe1, uint8_t Probe2, uint8_t Probe3)
 {
+#ifdef SW_PROBE_STATE
+  /* probes will be driven */
+  Probes.State &= ~PROBES_DISCHARGED;   /* might leave charge */
+#endif
+
   /* set probe IDs */
   Probes.ID_1 = Probe1;
   Probes.ID_2 = Probe2;
@@ -323,6 +372,274 @@ void DischargeCap(uint8_t Probe1, uint8_t Probe2)
 #endif // SW_ESR || SW_OLD__ESR
 
 
+#ifdef SW_PROBE_STATE
+
+/*
+ *  check if probes are still discharged
+ *  - for a DischargeProbes() run when the probes haven't been driven
+ *    since the last successful discharge
+ *  - a single conversion per probe with bandgap reference instead of
+ *    the discharge loop
+ *
+ *  returns:
+ *  - 1 if discharged
+ *  - 0 if not or probes have been driven
+ */
+
+uint8_t CheckDischarged(void)
+{
+  uint8_t           ID;                 /* test pin */
+  uint16_t          U;                  /* voltage */
+
+  if (! (Probes.State & PROBES_DISCHARGED))  /* driven since */
+    return 0;
+
+  Probes.State &= ~PROBES_DISCHARGED;   /* reset flag */
+
+  /* probes: pull down via Rh and Rl */
+  ADC_DDR = 0;
+  ADC_PORT = 0;
+  R_PORT = 0;
+  R_DDR = (1 << R_RH_1) | (1 << R_RH_2) | (1 << R_RH_3) |
+          (1 << R_RL_1) | (1 << R_RL_2) | (1 << R_RL_3);
+
+  for (ID = 0; ID < 3; ID++)            /* loop through probes */
+  {
+    /* single conversion (incl. dummy conversion) */
+    ADC_SetMux(DATA_read_byte(&Channel_table[ID]) | ADC_REF_BANDGAP);
+    ADC_Conversion();
+    U = ADC_ScaleU(ADCW, ADC_REF_BANDGAP, 1);
+
+    if (U > CAP_DISCHARGED)             /* charged */
+      return 0;
+  }
+
+  /* reset probes */
+  R_DDR = 0;                  /* set resistor port to input mode */
+
+  Probes.State |= PROBES_DISCHARGED;    /* still discharged */
+  return 1;
+}
+
+#endif // SW_PROBE_STATE
+
+
+#ifdef SW_DISCHARGE_MODEL
+
+/*
+ *  try to discharge any connected components, e.g. capacitors
+ *  - model based variant
+ *  - detect batteries
+ *  - sometimes large caps are detected as a battery
+ *  - updates discharge time constants in Check.Tau[]
+ *    (kept for the probing cycle)
+ */
+
+void DischargeProbes(void)
+{
+  uint8_t           ID;                 /* test pin */
+  uint8_t           Flags = 0;          /* discharge state flags */
+  uint8_t           Fit = 0;            /* flags for got sample */
+  uint8_t           Decrease;           /* flag for voltage decreased */
+  uint8_t           Sample;             /* flag for short sample */
+  uint8_t           Pin;                /* ADC port pin mask */
+  uint8_t           Channel;            /* ADC MUX channel */
+  uint16_t          U_c;                /* current voltage */
+  uint16_t          U_old[3];           /* old voltages */
+  uint16_t          k;                  /* decay (log2 * 256) */
+  uint16_t          Time = 0;           /* time between samples (ms) */
+  uint16_t          Wait;               /* time to wait (ms) */
+  uint16_t          Stall = 0;          /* time without decrease (ms) */
+  uint16_t          Limit = 2000;       /* sliding timeout (ms) */
+  uint32_t          Value;              /* temp. value */
+
+#ifdef SW_PROBE_STATE
+  if (CheckDischarged()) return;        /* nothing to do */
+#endif
+
+  /*
+   *  set probes to a safe discharge mode (pull-down via Rh) 
+   */
+
+  /* set ADC port to HiZ input */
+  ADC_DDR = 0;
+  ADC_PORT = 0;
+
+  /* all probe pins: Rh and Rl pull-down */
+  R_PORT = 0;
+  R_DDR = (1 << R_RH_1) | (1 << R_RH_2) | (1 << R_RH_3) |
+          (1 << R_RL_1) | (1 << R_RL_2) | (1 << R_RL_3);
+
+  /* reset old voltages */
+  U_old[0] = UINT16_MAX;
+  U_old[1] = UINT16_MAX;
+  U_old[2] = UINT16_MAX;
+
+  /*
+   *  try to discharge probes
+   *  - We read all probes in rounds and fit an exponential decay
+   *    U(t) = U_0 * e^(-t/tau) to the last two samples of each probe.
+   *    In log2 terms the voltage decreases by a constant k per time,
+   *    so the time left to reach the target voltage is
+   *    t = Time * (log2(U_c) - log2(U_target)) / k.
+   *  - We wait for the longest predicted time and verify the result
+   *    with the next round. Without any prediction we take a short
+   *    sample first and fall back to polling every 50ms if the voltage
+   *    doesn't decrease.
+   *  - The decay changes when a probe is pulled down directly
+   *    (< 400mV), so the target is 400mV first and CAP_DISCHARGED
+   *    after that.
+   *  - A slow discharge rate will increase the timeout to support
+   *    large caps. A battery won't discharge at all.
+   *  - tau = Time / (k * ln(2) / 256) = Time * 369 / k
+   *    (via Rl and Rh in parallel, while the DUT's other side is also
+   *    pulled down via its probe resistors)
+   */
+
+  while (1)
+  {
+    Decrease = 0;                       /* reset flag */
+    Sample = 0;                         /* reset flag */
+    Wait = 0;                           /* no prediction yet */
+
+    for (ID = 0; ID < 3; ID++)          /* loop through probes */
+    {
+      if (Flags & (1 << ID))            /* skip discharged probe */
+        continue;
+
+      /* get voltage at probe */
+      Channel = DATA_read_byte(&Channel_table[ID]);
+      Pin = DATA_read_byte(&Pin_table[ID]);
+      U_c = ReadU(Channel);
+
+      if (U_c <= CAP_DISCHARGED)        /* seems to be discharged */
+      {
+        Flags |= (1 << ID);             /* set flag for probe */
+        continue;
+      }
+
+      /* increase limit if we start at a low voltage */
+      if ((U_c < 10) && (Limit <= 2000))
+        Limit = 4000;
+
+      if (U_c < U_old[ID])              /* voltage decreased */
+        Decrease = 1;                   /* set flag */
+
+      if ((U_c < DISCHARGE_DIRECT) && (! (ADC_DDR & Pin)))
+      {
+        /* it's safe now to pull down probe pin directly */
+        ADC_DDR |= Pin;
+        Fit &= ~(1 << ID);              /* new decay: start over */
+        Sample = 1;                     /* take short sample */
+      }
+      else if (! (Fit & (1 << ID)))     /* first sample */
+      {
+        Fit |= (1 << ID);               /* got sample */
+        Sample = 1;                     /* take short sample */
+      }
+      else if (U_c < U_old[ID])         /* fit decay */
+      {
+        /* decay per Time */
+        k = Log2Value(U_old[ID]) - Log2Value(U_c);
+
+        if (k > 0)                      /* got rate */
+        {
+          /* time constant (only for discharge via probe resistors) */
+          if (! (ADC_DDR & Pin))
+          {
+            Value = (uint32_t)Time * 369;
+            Value /= k;
+            if (Value > UINT16_MAX) Value = UINT16_MAX;
+            Check.Tau[ID] = (uint16_t)Value;
+          }
+
+          /* predict time left to reach target voltage */
+          if (ADC_DDR & Pin)            /* direct pull-down */
+            Value = Log2Value(CAP_DISCHARGED);
+          else                          /* pull-down via probe resistors */
+            Value = Log2Value(DISCHARGE_DIRECT - 20);
+
+          Value = Log2Value(U_c) - Value;
+          Value *= Time;
+          Value /= k;
+          Value++;                      /* round up */
+
+          if (Value > Wait) Wait = (uint16_t)Value;
+        }
+      }
+
+      U_old[ID] = U_c;                  /* update old value */
+    }
+
+    if (Flags == 0b00000111)            /* all probes discharged */
+    {
+#ifdef SW_PROBE_STATE
+      Probes.State |= PROBES_DISCHARGED;     /* remember state */
+#endif
+      break;                            /* end loop */
+    }
+
+    if (Decrease)                       /* voltage decreased */
+    {
+      /* adapt timeout based on discharge rate */
+      if ((Limit - Stall) < 1000)
+      {
+        /* increase timeout while preventing overflow */
+        if (Limit < (12750 - 1000))
+          Limit += 1000;
+      }
+
+      Stall = 0;                        /* reset no-changes time */
+    }
+    else                                /* voltage not decreased */
+    {
+      Stall += Time;                    /* increase no-changes time */
+
+      if (Stall > Limit)                /* no decrease for some time */
+      {
+        /* might be a battery or a super cap */
+        ID = 0;                         /* first probe not discharged */
+        while (Flags & (1 << ID)) ID++;
+
+        Check.Found = COMP_ERROR;       /* report error */
+        Check.Type = TYPE_DISCHARGE;    /* discharge problem */
+        Check.Probe = ID;               /* save probe */
+
+        /* measure unloaded voltage */
+        Flags = DATA_read_byte(&Pin_table[ID]);
+        ADC_DDR &= ~Flags;              /* remove direct pull-down */
+        Flags = DATA_read_byte(&Rh_table[ID]) | DATA_read_byte(&Rl_table[ID]);
+        R_DDR &= ~Flags;                /* disable load resistors */
+        Channel = DATA_read_byte(&Channel_table[ID]);
+        Check.U = ReadU(Channel);       /* get and save voltage */
+
+        break;                          /* end loop */
+      }
+    }
+
+    /* time to wait */
+    if (Wait == 0)                      /* no prediction */
+    {
+      if (Sample)                       /* probe without decay yet */
+        Wait = DISCHARGE_SAMPLE;        /* take short sample */
+      else                              /* bad fit */
+        Wait = 50;                      /* poll every 50ms */
+    }
+    else if (Wait > DISCHARGE_MAX_WAIT) /* limit prediction */
+      Wait = DISCHARGE_MAX_WAIT;
+
+    wdt_reset();                        /* reset watchdog */
+    MilliSleep(Wait);                   /* wait */
+    Time = Wait;                        /* time between samples */
+  }
+
+  /* reset probes */
+  R_DDR = 0;                  /* set resistor port to input mode */
+  ADC_DDR = 0;                /* set ADC port to input mode */
+}
+
+#else
+
 /*
  *  try to discharge any connected components, e.g. capacitors
  *  - detect batteries
@@ -338,6 +655,13 @@ void DischargeProbes(void)
   uint8_t           Channel;            /* ADC MUX channel */
   uint16_t          U_c;                /* current voltage */
   uint16_t          U_old[3];           /* old voltages */
+#ifdef ADC_MULTI
+  uint8_t           Channels[3];        /* ADC MUX channels */
+#endif
+
+#ifdef SW_PROBE_STATE
+  if (CheckDischarged()) return;        /* nothing to do */
+#endif
 
   /*
    *  set probes to a safe discharge mode (pull-down via Rh) 
@@ -353,9 +677,16 @@ void DischargeProbes(void)
           (1 << R_RL_1) | (1 << R_RL_2) | (1 << R_RL_3);
 
   /* get current voltages */
+#ifdef ADC_MULTI
+  Channels[0] = TP1;
+  Channels[1] = TP2;
+  Channels[2] = TP3;
+  ReadU_Multi(3, Channels, U_old);      /* read all probes in one pass */
+#else
   U_old[0] = ReadU(TP1);
   U_old[1] = ReadU(TP2);
   U_old[2] = ReadU(TP3);
+#endif
 
   /*
    *  try to discharge probes
@@ -423,7 +754,12 @@ void DischargeProbes(void)
       ADC_DDR |= DATA_read_byte(&Pin_table[ID]);
 
     if (Flags == 0b00000111)            /* all probes discharged */
+    {
+#ifdef SW_PROBE_STATE
+      Probes.State |= PROBES_DISCHARGED;     /* remember state */
+#endif
       Counter = 0;                      /* end loop */
+    }
     else if (Counter > Limit)           /* no decrease for some time */
     {
       /* might be a battery or a super cap */
@@ -452,6 +788,8 @@ void DischargeProbes(void)
   ADC_DDR = 0;                /* set ADC port to input mode */
 }
 
+#endif // SW_DISCHARGE_MODEL
+
 
 /*
  *  pull probe up/down via probe resistor for 1 or 10 ms
@@ -467,6 +805,10 @@ void DischargeProbes(void)
 
 void PullProbe(uint8_t Mask, uint8_t Mode)
 {
+#ifdef SW_PROBE_STATE
+  Probes.State &= ~PROBES_DISCHARGED;   /* might leave charge */
+#endif
+
   /* set pull mode */
   if (Mode & PULL_UP)         /* pull-up */
     R_PORT |= Mask;                /* set bit */
@@ -489,6 +831,97 @@ void PullProbe(uint8_t Mask, uint8_t Mode)
  *   calculation support
  * ************************************************************************ */
 
+#ifdef SW_FACTOR_SEGMENTS
+
+/*
+ *  lookup a voltage/ratio based factor in fixed-point segments
+ *  - segments of 2^n mV (or ratio) with intercept and slope
+ *    (generated by script/incgen-factor from the tables)
+ *  - value decreases with index position
+ *  - beyond the last segment: end of last segment
+ *
+ *  requires:
+ *  - voltage (in mV) or ratio
+ *  - table ID
+ *
+ *  returns:
+ *  - multiplicator/factor
+ */
+
+uint16_t GetFactor(uint16_t U_in, uint8_t ID)
+{
+  uint16_t          Factor;             /* return value */
+  uint16_t          U_Diff;             /* voltage difference to start */
+  uint16_t          Index;              /* segment index */
+  uint16_t          *Table;             /* pointer to segments */
+  uint16_t          Diff;               /* difference to segment start */
+  uint8_t           Shift;              /* segment size (2^n) */
+  uint8_t           Num;                /* number of segments */
+  uint32_t          Value;              /* temp. value */
+
+  /*
+   *  set up table specific stuff
+   */
+
+  if (ID == TABLE_SMALL_CAP)
+  {
+    U_Diff = FACTOR_SMALL_CAP_START;         /* start voltage */
+    Shift = FACTOR_SMALL_CAP_SHIFT;          /* segment size */
+    Num = FACTOR_SMALL_CAP_NUM;              /* number of segments */
+    Table = (uint16_t *)&SmallCap_seg[0];    /* pointer to segments */
+  }
+  else if (ID == TABLE_LARGE_CAP)
+  {
+    U_Diff = FACTOR_LARGE_CAP_START;         /* start voltage */
+    Shift = FACTOR_LARGE_CAP_SHIFT;          /* segment size */
+    Num = FACTOR_LARGE_CAP_NUM;              /* number of segments */
+    Table = (uint16_t *)&LargeCap_seg[0];    /* pointer to segments */
+  }
+#ifdef SW_INDUCTOR
+  else if (ID == TABLE_INDUCTOR)
+  {
+    U_Diff = FACTOR_INDUCTOR_START;          /* start ratio */
+    Shift = FACTOR_INDUCTOR_SHIFT;           /* segment size */
+    Num = FACTOR_INDUCTOR_NUM;               /* number of segments */
+    Table = (uint16_t *)&Inductor_seg[0];    /* pointer to segments */
+  }
+#endif
+  else
+    return 0;                 /* signal error */
+
+  /* difference to start */
+  if (U_in >= U_Diff)
+    U_Diff = U_in - U_Diff;
+  else
+    U_Diff = 0;
+
+  /* segment and difference to its start */
+  Index = U_Diff >> Shift;
+  Diff = U_Diff & ((1 << Shift) - 1);
+
+  if (Index >= Num)           /* beyond last segment */
+  {
+    Index = Num - 1;          /* last segment */
+    Diff = 1 << Shift;        /* end of segment */
+  }
+
+  /* get intercept and slope */
+  Table += Index * 2;                   /* advance to segment */
+  Factor = DATA_read_word(Table);       /* intercept */
+  Table++;                              /* slope */
+
+  /* factor = intercept - slope * diff / 2^n */
+  Value = DATA_read_word(Table);
+  Value *= Diff;
+  Value += (1 << Shift) / 2;            /* for rounding */
+  Value >>= Shift;
+  Factor -= (uint16_t)Value;
+
+  return Factor;
+}
+
+#else
+
 /*
  *  lookup a voltage/ratio based factor in a table and interpolate it's value
  *  - value decreases with index position
@@ -578,6 +1011,8 @@ uint16_t GetFactor(uint16_t U_in, uint8_t ID)
   return Factor;
 }
 
+#endif // SW_FACTOR_SEGMENTS
+
 
 #if defined (FUNC_EVALUE) || defined (FUNC_COLORCODE) || defined (FUNC_EIA96)
 
@@ -595,7 +1030,7 @@ uint16_t GetFactor(uint16_t U_in, uint8_t ID)
  *  requires:
  *  - Value: unsigned value
  *  - Scale: exponent/multiplier (* 10^n)
- *  - E_Series: E6 - E96
+ *  - E_Series: E6 - E192
  *  - Tolerance: tolerance (in 0.1%)
  *
  *  returns:
@@ -608,8 +1043,11 @@ uint8_t GetENormValue(uint32_t Value, int8_t Scale, uint8_t E_Series, uint8_t To
 {
   uint8_t           Ret = 0;            /* return values */
   uint16_t          *Table;             /* pointer to table */
-  uint8_t           Index;              /* table index */
-  uint8_t           n;                  /* counter */
+  uint8_t           Index;              /* number of norm values */
+  uint8_t           Step = 1;           /* step size of table index */
+  uint8_t           n;                  /* table index */
+  uint8_t           Top;                /* upper limit of search */
+  uint8_t           Mid;                /* middle of search range */
   uint16_t          Norm;               /* norm value */
   uint16_t          LowVal = 0;         /* lower norm value */
   uint16_t          HighVal = 0;        /* higher norm value */
@@ -659,13 +1097,38 @@ uint8_t GetENormValue(uint32_t Value, int8_t Scale, uint8_t E_Series, uint8_t To
       break;
 #endif
 
+#ifdef SW_E48
+    case E48:                                /* E48 */
+  #ifdef SW_E192
+      Table = (uint16_t *)&E192_table[0];    /* pointer to table */
+      Step = 4;                              /* every 4th value */
+  #else
+      Table = (uint16_t *)&E96_table[0];     /* pointer to table */
+      Step = 2;                              /* every 2nd value */
+  #endif
+      Index = NUM_E48;                       /* 48 values */
+      break;
+#endif
+
 #ifdef SW_E96
     case E96:                                /* E96 */
+  #ifdef SW_E192
+      Table = (uint16_t *)&E192_table[0];    /* pointer to table */
+      Step = 2;                              /* every 2nd value */
+  #else
       Table = (uint16_t *)&E96_table[0];     /* pointer to table */
+  #endif
       Index = NUM_E96;                       /* 96 values */
       break;
 #endif
 
+#ifdef SW_E192
+    case E192:                               /* E192 */
+      Table = (uint16_t *)&E192_table[0];    /* pointer to table */
+      Index = NUM_E192;                      /* 192 values */
+      break;
+#endif
+
     default:                                 /* no matching E series */
       return Ret;                            /* signal error */
   }
@@ -695,54 +1158,51 @@ uint8_t GetENormValue(uint32_t Value, int8_t Scale, uint8_t E_Series, uint8_t To
    *  - for finding norm values
    */
 
-  while (Value >= 1000)       /* upper limit */
-  {
-    /* todo: round? */
-    Value /= 10;              /* /10 */
-    Scale++;                  /* increase multiplier */
-  }
+  /* todo: round? */
+  Value /= 100;               /* /100 */
+  Scale += 2;                 /* increase multiplier */
 
   HighScale = Scale;          /* save multiplier */
 
   /*
    *  get lower and higher norm value from table
+   *  - binary search for first norm value >= component value
    */
 
-  n = 0;                      /* reset counter */
+  n = 0;                      /* lower limit */
+  Top = Index;                /* upper limit */
 
-  while (n < Index)           /* loop through table */
+  while (n < Top)             /* search range not empty */
   {
-    Norm = DATA_read_word(Table);  /* read norm value */
+    Mid = n + (Top - n) / 2;       /* middle of range */
+    Norm = DATA_read_word(Table + (uint16_t)Mid * Step);   /* read norm value */
 
     if (Norm < (uint16_t)Value)    /* norm value lower */
-    {
-      LowVal = Norm;               /* update lower norm value */
-#ifdef FUNC_EIA96
-      LowIndex = n;                /* update index number */
-#endif
-    }
+      n = Mid + 1;                 /* search upper half */
     else                           /* norm value higher */
-    {
-      HighVal = Norm;              /* save higher norm value */
+      Top = Mid;                   /* search lower half */
+  }
+
+  if (n > 0)                       /* got lower norm value */
+  {
+    LowVal = DATA_read_word(Table + (uint16_t)(n - 1) * Step);
 #ifdef FUNC_EIA96
-      HighIndex = n;               /* save index number */
+    LowIndex = n - 1;              /* index number */
 #endif
-      break;                       /* end loop */
-    }
-
-    Table++;                       /* next element */
-    n++;                           /* next one */
   }
 
-  /* manage table index overflow */
-  if (n == Index)                  /* reached last element */
+  if (n < Index)                   /* got higher norm value */
   {
-    /* higher norm value is 1000 (100 and multiplier + 1) */
-    HighVal = 1000;
+    HighVal = DATA_read_word(Table + (uint16_t)n * Step);
 #ifdef FUNC_EIA96
-    HighIndex = 0;                 /* reset index number */
+    HighIndex = n;                 /* index number */
 #endif
   }
+  else                             /* table index overflow */
+  {
+    /* higher norm value is 1000 (100 and multiplier + 1) */
+    HighVal = 1000;
+  }
 
 #ifdef FUNC_EIA96
   /* adjust index number to start at 1 */
@@ -855,6 +1315,10 @@ void CheckProbes(uint8_t Probe1, uint8_t Probe2, uint8_t Probe3)
   wdt_reset();                             /* reset watchdog */
   UpdateProbes(Probe1, Probe2, Probe3);    /* update register bits */
 
+#ifdef SW_SAME_AS_LAST
+  Last_Mark();                             /* save detection state */
+#endif
+
   /*
    *  We measure the current from probe 2 to ground with probe 1 pulled up
    *  to 5V and probe 3 in HiZ mode to determine if we got a self-conducting
@@ -1024,7 +1488,7 @@ void CheckProbes(uint8_t Probe1, uint8_t Probe2, uint8_t Probe3)
       if (U_1 < 1600)                       /* detected current > 4.8mA */
       {
         /* first check for Thyristor and TRIAC */
-        if (CheckThyristorTriac())          /* no Thyristor or TRIAC */
+        if (CheckThyristorTriac() == 0)     /* no Thyristor or TRIAC */
         {
           /* If we've detected a TRIAC in a former run don't check for BJT. */
           if (Check.Found != COMP_TRIAC)
@@ -1098,6 +1562,10 @@ void CheckProbes(uint8_t Probe1, uint8_t Probe2, uint8_t Probe3)
   ADC_PORT = 0;          /* set ADC port low */
   R_DDR = 0;             /* set resistor port to HiZ mode */
   R_PORT = 0;            /* set resistor port low */
+
+#ifdef SW_SAME_AS_LAST
+  Last_Track(Probe1, Probe2);    /* permutation added something? */
+#endif
 }
 
 /*
@@ -1141,3 +1609,108 @@ next:
    *  add other special checks here
   */
 }
+
+
+
+#ifdef SW_PROBE_SCHEDULER
+
+/*
+ *  check if a probe permutation could change the result
+ *  - for an identified transistor, Thyristor or TRIAC (DONE_SEMI)
+ *  - CheckProbes() would only look for diodes then
+ *
+ *  requires:
+ *  - Probe1: ID of probe #1
+ *  - Probe2: ID of probe #2
+ *  - Probe3: ID of probe #3
+ *
+ *  returns:
+ *  - 1 if permutation is required
+ *  - 0 if permutation can be skipped
+ */
+
+uint8_t RequiredProbes(uint8_t Probe1, uint8_t Probe2, uint8_t Probe3)
+{
+  /*
+   *  C-E, D-S, A-C or MT2-MT1 in both directions
+   *  - verification run (BJT, TRIAC, VerifyMOSFET())
+   *  - flyback diode or body diode
+   */
+
+  if (Probe3 == Semi.A) return 1;       /* base/gate is probe-3 */
+
+  /*
+   *  B-E and B-C diodes of a BJT
+   *  - V_BE and Schottky clamping diode
+   */
+
+  if (Check.Found == COMP_BJT)
+  {
+    if (Check.Type & TYPE_NPN)     /* NPN */
+    {
+      if (Probe1 == Semi.A) return 1;   /* base is anode */
+    }
+    else                           /* PNP */
+    {
+      if (Probe2 == Semi.A) return 1;   /* base is cathode */
+    }
+  }
+
+  return 0;                        /* nothing new */
+}
+
+
+/*
+ *  check the probe permutations required for identification
+ *  - replaces the fixed sequence of 6 CheckProbes() calls
+ *  - runs permutations in the order of Permutation_table[]
+ *  - skips permutations which can't change the result after a
+ *    transistor, Thyristor or TRIAC has been identified
+ *  - runs skipped permutations if the identification is withdrawn
+ *    later on (VerifyMOSFET())
+ */
+
+void CheckAllProbes(void)
+{
+  uint8_t           Pending = 0b00111111;  /* permutations to run */
+  uint8_t           Skipped;       /* skipped permutations */
+  uint8_t           Mask;          /* bit mask for permutation */
+  uint8_t           n;             /* counter */
+  uint8_t           Perm;          /* permutation */
+  uint8_t           Probe1;        /* ID of probe #1 */
+  uint8_t           Probe2;        /* ID of probe #2 */
+  uint8_t           Probe3;        /* ID of probe #3 */
+
+  while (Pending)
+  {
+    Skipped = 0;
+    Mask = 0b00000001;
+
+    for (n = 0; n < 6; n++)
+    {
+      if (Pending & Mask)          /* permutation not run yet */
+      {
+        /* get probe IDs */
+        Perm = DATA_read_byte(&Permutation_table[n]);
+        Probe1 = (Perm >> 4) & 0b00000011;
+        Probe2 = (Perm >> 2) & 0b00000011;
+        Probe3 = Perm & 0b00000011;
+
+        if (! (Check.Done & DONE_SEMI) ||
+            RequiredProbes(Probe1, Probe2, Probe3))
+          CheckProbes(Probe1, Probe2, Probe3);
+        else                       /* nothing new to find */
+          Skipped |= Mask;         /* remember permutation */
+      }
+
+      Mask <<= 1;                  /* next permutation */
+    }
+
+    /* identification still valid: done */
+    if (Check.Done & DONE_SEMI) break;
+
+    Pending = Skipped;             /* catch up on skipped ones */
+  }
+}
+
+#endif // SW_PROBE_SCHEDULER
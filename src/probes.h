@@ -15,7 +15,9 @@
 #define NUM_E6                6         /* E6 norm values */
 #define NUM_E12              12         /* E12 norm values */
 #define NUM_E24              24         /* E24 norm values */
-#define NUM_E96              96         /* E24 norm values */
+#define NUM_E48              48         /* E48 norm values */
+#define NUM_E96              96         /* E96 norm values */
+#define NUM_E192            192         /* E192 norm values */
 
 
 /* E series */
@@ -31,6 +33,18 @@
 #define PROBE_2               1    /* probe #2 */
 #define PROBE_3               2    /* probe #3 */
 
+/* DischargeProbes() */
+#ifdef SW_DISCHARGE_MODEL
+#define DISCHARGE_DIRECT    400    /* direct pull-down below (mV) */
+#define DISCHARGE_SAMPLE     10    /* time for first sample (ms) */
+#define DISCHARGE_MAX_WAIT  500    /* max. predicted wait (ms) */
+
+#define FUNC_LOG2VALUE
+#endif
+
+/* state flags for Probes.State (bitfield) */
+#define PROBES_DISCHARGED     0b00000001     /* discharged, not driven since */
+
 /* bit flags for PullProbe() (bitfield) */
 #define PULL_DOWN             0b00000000     /* pull down */
 #define PULL_UP               0b00000001     /* pull up */
@@ -64,6 +78,11 @@ typedef struct
   uint8_t           Ch_1;          /* ADC MUX input channel for probe-1 */
   uint8_t           Ch_2;          /* ADC MUX input channel for probe-2 */
   uint8_t           Ch_3;          /* ADC MUX input channel for probe-3 */
+
+#ifdef SW_PROBE_STATE
+  /* state tracker */
+  uint8_t           State;         /* state flags */
+#endif
 } Probe_Type;
 
 
@@ -99,11 +118,21 @@ extern const uint16_t E12_table[];
 extern const uint16_t E24_table[];
 #endif
 
-#ifdef SW_E96
+#if (defined (SW_E48) || defined (SW_E96)) && !defined (SW_E192)
 /* E96 (in 0.01) */
 extern const uint16_t E96_table[];
 #endif
 
+#ifdef SW_E192
+/* E192 (in 0.01) */
+extern const uint16_t E192_table[];
+#endif
+
+#if defined (SW_PROBE_SCHEDULER) || defined (SW_SAME_AS_LAST)
+/* probe permutations */
+extern const uint8_t Permutation_table[];
+#endif
+
 
 extern void UpdateProbes(uint8_t Probe1, uint8_t Probe2, uint8_t Probe3);
 extern void UpdateProbes2(uint8_t Probe1, uint8_t Probe2);
@@ -127,6 +156,10 @@ extern uint8_t GetENormValue(uint32_t Value, int8_t Scale, uint8_t E_Series, uin
 extern void CheckProbes(uint8_t Probe1, uint8_t Probe2, uint8_t Probe3);
 extern void CheckAlternatives(void);
 
+#ifdef SW_PROBE_SCHEDULER
+extern void CheckAllProbes(void);
+#endif
+
 
 /* probing */
 extern Probe_Type      Probes;             /* test probes */
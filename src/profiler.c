@@ -0,0 +1,362 @@
+/* ************************************************************************
+ *
+ *   probing cycle profiler
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+/*
+ *  hints:
+ *  - Timer1 runs with 1/1 clock divider while the probing cycle is
+ *    profiled, its overflow interrupt extends the counter to 32 bits
+ *    (ticks = MCU cycles, about 268s at 16MHz)
+ *  - a code section running with disabled interrupts for more than
+ *    65536 MCU cycles loses overflows
+ *  - measurements using Timer1 (SmallCap(), MeasureInductance()) borrow
+ *    the timer via Prof_Pause() and return their own counter value via
+ *    Prof_Continue()
+ *  - Timer1 doesn't run in power save mode, so MilliSleep() pauses the
+ *    profiler and adds the sleep time when done
+ *  - wait*() functions of 1ms and longer are wrapped by macros (see wait.h),
+ *    the s-range waits are too short to be profiled
+ */
+
+
+/*
+ *  include header files
+ */
+
+/* local includes */
+#include "common.h"                /* common header file */
+
+
+#ifdef SW_PROFILER
+
+/*
+ *  local constants
+ */
+
+/* output */
+#ifdef UI_SERIAL_COPY
+#define PROF_DECIMALS    3         /* ms with 3 decimal places */
+#else
+#define PROF_DECIMALS    0         /* full ms (narrow display) */
+#endif
+
+
+/*
+ *  local variables
+ */
+
+/* profiler state */
+Prof_Type              Prof;
+
+/* stage labels */
+const unsigned char    Prof_Label[PROF_STAGES] = {'D', 'P', 'A', 'C', 'S'};
+
+
+
+/* ************************************************************************
+ *   ISR
+ * ************************************************************************ */
+
+/*
+ *  ISR for overflow of Timer1
+ *  - upper 16 bits of tick counter
+ */
+
+ISR(TIMER1_OVF_vect, ISR_BLOCK)
+{
+  /*
+   *  HINTs:
+   *  - the TOV1 interrupt flag is cleared automatically
+   *  - interrupt processing is disabled while this ISR runs
+   *    (no nested interrupts)
+   */
+
+  Prof.Overflows++;                /* next 65536 cycles */
+}
+
+
+
+/* ************************************************************************
+ *   tick counter
+ * ************************************************************************ */
+
+/*
+ *  get current tick
+ *  - considers a pending overflow
+ *
+ *  returns:
+ *  - ticks (MCU cycles)
+ */
+
+uint32_t Prof_Tick(void)
+{
+  uint32_t          Tick;          /* return value */
+  uint16_t          Low;           /* lower 16 bits */
+  uint8_t           Old_SREG;      /* old SREG */
+
+  Old_SREG = SREG;                 /* save interrupt setting */
+  cli();                           /* disable interrupts */
+
+  Tick = Prof.Overflows;           /* get upper 16 bits */
+  Low = TCNT1;                     /* get counter */
+
+  /* overflow not processed yet (interrupts disabled) */
+  if (TIFR1 & (1 << TOV1))
+  {
+    Low = TCNT1;                   /* counter after overflow */
+    Tick++;                        /* consider overflow */
+  }
+
+  SREG = Old_SREG;                 /* restore interrupt setting */
+
+  Tick <<= 16;
+  Tick |= Low;
+
+  return Tick;
+}
+
+
+/*
+ *  set tick and (re)start Timer1
+ *
+ *  requires:
+ *  - Tick: new tick value
+ */
+
+void Prof_SetTick(uint32_t Tick)
+{
+  TCCR1B = 0;                      /* stop timer */
+  TIMSK1 = 0;                      /* disable interrupts */
+  TCCR1A = 0;                      /* normal mode */
+  TCNT1 = (uint16_t)Tick;          /* lower 16 bits */
+  Prof.Overflows = (uint16_t)(Tick >> 16);   /* upper 16 bits */
+  TIFR1 = (1 << ICF1) | (1 << OCF1B) | (1 << OCF1A) | (1 << TOV1);
+  TIMSK1 = (1 << TOIE1);           /* enable overflow interrupt */
+  TCCR1B = (1 << CS10);            /* start timer (1/1 clock divider) */
+}
+
+
+
+/* ************************************************************************
+ *   control
+ * ************************************************************************ */
+
+/*
+ *  start profiling a probing cycle
+ *  - resets all stage times
+ */
+
+void Prof_Start(void)
+{
+  memset(&Prof, 0, sizeof(Prof));  /* reset everything */
+  Prof.Current = PROF_NONE;        /* no stage yet */
+
+  Prof_SetTick(0);                 /* start Timer1 */
+  Prof.Flags = PROF_ACTIVE;        /* we are running */
+}
+
+
+/*
+ *  stop profiling
+ *  - ends current stage
+ */
+
+void Prof_Stop(void)
+{
+  if (! (Prof.Flags & PROF_ACTIVE)) return;   /* not running */
+
+  Prof_Leave();                    /* end current stage */
+
+  Prof.Mark = Prof_Tick();         /* save end of cycle */
+  TCCR1B = 0;                      /* stop timer */
+  TIMSK1 = 0;                      /* disable interrupts */
+  TIFR1 = (1 << TOV1);             /* clear overflow flag */
+
+  Prof.Flags = 0;                  /* not running anymore */
+}
+
+
+/*
+ *  enter stage
+ *  - ends former stage
+ *
+ *  requires:
+ *  - Stage: stage ID
+ */
+
+void Prof_Enter(uint8_t Stage)
+{
+  if (! (Prof.Flags & PROF_ACTIVE)) return;   /* not running */
+
+  Prof_Leave();                    /* end former stage */
+
+  Prof.Entry = Prof_Tick();        /* save entry time */
+  Prof.Current = Stage;            /* set stage */
+}
+
+
+/*
+ *  leave current stage
+ */
+
+void Prof_Leave(void)
+{
+  if (! (Prof.Flags & PROF_ACTIVE)) return;   /* not running */
+  if (Prof.Current >= PROF_STAGES) return;    /* no stage */
+
+  Prof.Stage[Prof.Current].Total += Prof_Tick() - Prof.Entry;
+  Prof.Current = PROF_NONE;        /* no stage */
+}
+
+
+/*
+ *  lend Timer1 to a measurement or sleep
+ *  - stops the tick counter
+ */
+
+void Prof_Pause(void)
+{
+  if (Prof.Flags != PROF_ACTIVE) return;      /* not running or paused */
+
+  Prof.Mark = Prof_Tick();         /* save tick */
+  TCCR1B = 0;                      /* stop timer */
+  TIMSK1 = 0;                      /* disable interrupts */
+
+  Prof.Flags |= PROF_PAUSED;       /* timer is lent */
+}
+
+
+/*
+ *  get Timer1 back and restart tick counter
+ *
+ *  requires:
+ *  - Cycles: MCU cycles passed while paused
+ *  - Type: PROF_MEASURE or PROF_SLEEP
+ */
+
+void Prof_Continue(uint32_t Cycles, uint8_t Type)
+{
+  if (! (Prof.Flags & PROF_PAUSED)) return;   /* not paused */
+
+  Prof_SetTick(Prof.Mark + Cycles);     /* continue counting */
+  Prof.Flags &= ~PROF_PAUSED;           /* timer is back */
+
+  if ((Type == PROF_SLEEP) && (Prof.Current < PROF_STAGES))
+    Prof.Stage[Prof.Current].Sleep += Cycles;
+}
+
+
+/*
+ *  start of wait function
+ */
+
+void Prof_WaitStart(void)
+{
+  if (Prof.Flags != PROF_ACTIVE) return;      /* not running or paused */
+
+  Prof.Mark = Prof_Tick();         /* save tick */
+}
+
+
+/*
+ *  end of wait function
+ */
+
+void Prof_WaitStop(void)
+{
+  if (Prof.Flags != PROF_ACTIVE) return;      /* not running or paused */
+  if (Prof.Current >= PROF_STAGES) return;    /* no stage */
+
+  Prof.Stage[Prof.Current].Wait += Prof_Tick() - Prof.Mark;
+}
+
+
+
+/* ************************************************************************
+ *   output
+ * ************************************************************************ */
+
+/*
+ *  display time
+ *
+ *  requires:
+ *  - Cycles: time in MCU cycles
+ */
+
+void Prof_DisplayTime(uint32_t Cycles)
+{
+  Cycles /= MCU_CYCLES_PER_US;          /* convert to s */
+#if PROF_DECIMALS == 0
+  Cycles /= 1000;                       /* convert to ms */
+#endif
+
+  Display_Space();
+  Display_FullValue(Cycles, PROF_DECIMALS, 0);
+}
+
+
+/*
+ *  output stage times of last probing cycle
+ *  - via TTL serial when serial copy is enabled,
+ *    otherwise on the display (after key press or timeout)
+ *  - one line per stage: label, total, wait*() and MilliSleep() in ms
+ *  - last line: complete probing cycle
+ */
+
+void Prof_Report(void)
+{
+  Prof_Stage_Type   *Stage;        /* pointer to stage */
+  uint8_t           n;             /* counter */
+#ifdef UI_SERIAL_COPY
+  uint8_t           Old_Control;   /* old output control */
+#endif
+
+  Prof_Stop();                     /* make sure profiler is stopped */
+
+#ifdef UI_SERIAL_COPY
+  /* output to serial only */
+  Old_Control = Cfg.OP_Control;              /* save output settings */
+  Cfg.OP_Control &= ~OP_OUT_LCD;             /* disable display output */
+  Cfg.OP_Control |= OP_OUT_SER;              /* enable serial output */
+  Serial_NewLine();                          /* serial: new line */
+#else
+  /* keep results on the display for a while */
+  TestKey((uint16_t)CYCLE_DELAY, CURSOR_BLINK);
+  LCD_Clear();                               /* clear display */
+#endif
+
+  /* title */
+  Display_Char('t');
+  Display_Char('/');
+  Display_Char('m');
+  Display_Char('s');
+
+  /* stages */
+  Stage = &Prof.Stage[0];
+  for (n = 0; n < PROF_STAGES; n++)
+  {
+    Display_NextLine();
+    Display_Char(Prof_Label[n]);        /* display: label */
+    Prof_DisplayTime(Stage->Total);     /* display: total */
+    Prof_DisplayTime(Stage->Wait);      /* display: wait */
+    Prof_DisplayTime(Stage->Sleep);     /* display: sleep */
+    Stage++;                            /* next stage */
+  }
+
+  /* complete cycle */
+  Display_NextLine();
+  Display_Char('T');
+  Prof_DisplayTime(Prof.Mark - Prof.Start);
+
+#ifdef UI_SERIAL_COPY
+  Serial_NewLine();                          /* serial: new line */
+  Cfg.OP_Control = Old_Control;              /* restore output settings */
+#endif
+}
+
+
+#endif // SW_PROFILER
@@ -0,0 +1,74 @@
+/* ************************************************************************
+ *
+ *   probing cycle profiler
+ *
+ *   (c) 2025 by gadefox@EEVblog
+ *
+ * ************************************************************************ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+
+#ifdef SW_PROFILER
+
+#define FUNC_DISPLAY_FULLVALUE
+
+
+/* stages of probing cycle (Prof_Enter()) */
+#define PROF_DISCHARGE        0    /* DischargeProbes() */
+#define PROF_CHECK            1    /* CheckProbes() */
+#define PROF_ALTERNATIVES     2    /* CheckAlternatives() */
+#define PROF_CAP              3    /* MeasureCap() */
+#define PROF_SHOW             4    /* output of results */
+#define PROF_STAGES           5    /* number of stages */
+#define PROF_NONE          0xFF    /* no stage */
+
+/* profiler flags (Prof_Type.Flags) */
+#define PROF_ACTIVE           0b00000001     /* Timer1 is counting */
+#define PROF_PAUSED           0b00000010     /* Timer1 lent to measurement */
+
+/* type of bridged time (Prof_Continue()) */
+#define PROF_MEASURE          0    /* measurement using Timer1 */
+#define PROF_SLEEP            1    /* MilliSleep() */
+
+
+/* time spent in a stage (in MCU cycles) */
+typedef struct
+{
+  uint32_t          Total;         /* total time */
+  uint32_t          Wait;          /* time in wait*() */
+  uint32_t          Sleep;         /* time in MilliSleep() */
+} Prof_Stage_Type;
+
+/* profiler state */
+typedef struct
+{
+  Prof_Stage_Type   Stage[PROF_STAGES];   /* stage times */
+  uint32_t          Start;         /* tick at start of cycle */
+  uint32_t          Entry;         /* tick at entry of stage */
+  uint32_t          Mark;          /* tick at start of wait/pause */
+  volatile uint16_t Overflows;     /* Timer1 overflows (upper 16 bits) */
+  uint8_t           Current;       /* current stage */
+  uint8_t           Flags;         /* state flags */
+} Prof_Type;
+
+extern Prof_Type    Prof;
+
+
+extern uint32_t Prof_Tick(void);
+extern void Prof_Start(void);
+extern void Prof_Stop(void);
+extern void Prof_Enter(uint8_t Stage);
+extern void Prof_Leave(void);
+extern void Prof_Pause(void);
+extern void Prof_Continue(uint32_t Cycles, uint8_t Type);
+extern void Prof_WaitStart(void);
+extern void Prof_WaitStop(void);
+extern void Prof_Report(void);
+
+
+#endif // SW_PROFILER
+
+
+#endif // PROFILER_H
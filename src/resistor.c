@@ -94,12 +94,41 @@ uint16_t SmallResistor(uint8_t ZeroFlag)
       Probe = Probes.Ch_2;    /* measure at probe 2 */
 
     wdt_reset();              /* reset watchdog */
+
+#ifdef ADC_OVERSAMPLING
+    /*
+     *  oversampling (16 runs of 4 readings, 13 bit in total)
+     *  - low voltage at DUT, bandgap reference like the direct ADC
+     *    readings below (also with auto-scaling disabled)
+     *  - runs spread over about 50ms like the direct ADC readings
+     *    to average out mains hum
+     *  - scale to sum of 100 samples in mV (10V) for processing below
+     */
+
+    Probe |= ADC_REF_BANDGAP;      /* force bandgap reference */
+    Counter = 0;                   /* reset loop counter */
+    Value = 0;                     /* reset sample value */
+
+    while (Counter < 16)
+    {
+      Value += ReadU_uV(Probe, 1);      /* voltage in V (about 0.6ms) */
+      wait2ms();                        /* wait */
+      wait500us();
+
+      Counter++;                        /* next run */
+    }
+
+    Value /= 16 * 10;              /* average in 10V */
+#else
     Counter = 0;              /* reset loop counter */
     Value = 0;                /* reset sample value */
 
     /* set ADC to use bandgap reference and run a dummy conversion */
     Probe |= ADC_REF_BANDGAP;
     ADMUX = Probe;                   /* set input channel and U reference */
+#ifdef ADC_STATE_CACHE
+    ADC_State.Flags &= ~ADC_STATE_VALID;  /* ADC state unknown */
+#endif
 #ifndef ADC_LARGE_BUFFER_CAP
     /* buffer cap: 1nF or none at all */
     wait100us();                   /* time for voltage stabilization */
@@ -130,6 +159,7 @@ uint16_t SmallResistor(uint8_t ZeroFlag)
     Value *= Cfg.Bandgap;          /* * U_bandgap */
     Value /= 1024;                 /* / 1024 for 10bit ADC */
 //    todo!!!! LGT
+#endif
 
     /* loop control */
     if (Mode & MODE_HIGH)          /* probe #1 / Rl */
@@ -191,8 +221,10 @@ uint16_t SmallResistor(uint8_t ZeroFlag)
 #undef MODE_LOW
 #undef MODE_HIGH
 
+#ifndef ADC_OVERSAMPLING
   /* update reference source for next ADC run */
   Cfg.Ref = ADC_REF_BANDGAP;       /* we've used the bandgap reference */
+#endif
 
   return R;
 }
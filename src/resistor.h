@@ -41,13 +41,23 @@
 #define SW_E24
 #endif
 
+/* option: E48 norm values */
+#ifdef SW_R_E48_T
+#define SW_E48
+#endif
+
 /* option: E96 norm values */
 #if defined (SW_R_E96_T) || defined (SW_R_E96_CC) || defined (SW_R_E96_EIA96)
 #define SW_E96
 #endif
 
+/* option: E192 norm values */
+#ifdef SW_R_E192_T
+#define SW_E192
+#endif
+
 /* functions: Show_ENormValues(), Display_EValue() */
-#if defined (SW_R_E24_5_T) || defined (SW_R_E24_1_T) || defined (SW_R_E96_T)
+#if defined (SW_R_E24_5_T) || defined (SW_R_E24_1_T) || defined (SW_R_E48_T) || defined (SW_R_E96_T) || defined (SW_R_E192_T)
 #define FUNC_EVALUE
 #define SW_R_EXX
 #endif
@@ -45,6 +45,11 @@ Diode_Type        Diodes[6];               /* diodes */
 Semi_Type         Semi;                    /* common semiconductor */
 AltSemi_Type      AltSemi;                 /* special semiconductor */
 
+#ifdef SW_HFE_SWEEP
+hFE_Point_Type    hFE_Points[HFE_SWEEP_POINTS];  /* hFE sweep */
+uint8_t           hFE_Count;               /* number of points */
+#endif
+
 
 /* ************************************************************************
  *   support functions
@@ -126,6 +131,8 @@ void SemiPinDesignators(void)
  *  measure leakage current
  *  - current through a semiconducter in non-conducting mode
  *  - result is stored in Semi.I_value & I.scale
+ *  - with SW_LEAK_RANGING: tiny currents are integrated by oversampling
+ *    and the uncertainty is stored in Semi.I_error
  *
  *  requires:
  *  - mode:
@@ -139,6 +146,12 @@ void GetLeakageCurrent(uint8_t Mode)
   uint32_t               Value;         /* current */
   uint32_t               R_Shunt;       /* shunt resistor */
   uint16_t               U_Rl;          /* voltage at Rl */
+#ifdef SW_LEAK_RANGING
+  uint8_t                Bits = 0;      /* additional ADC resolution */
+  uint8_t                Runs = 1;      /* number of readings */
+  uint8_t                n;             /* counter */
+  uint32_t               Step;          /* ADC step */
+#endif
 
   /*
    *  set up probes:
@@ -203,6 +216,32 @@ void GetLeakageCurrent(uint8_t Mode)
     R_Shunt =  R_HIGH;
     Scale = -9;                         /* 1n */
     Value = 1000000;                    /* scale voltage to 1 nV */
+
+#ifdef SW_LEAK_RANGING
+    if (U_Rl < LEAK_RANGE_U)            /* tiny current */
+    {
+      /*
+       *  Integrate by oversampling:
+       *  - 13 bit readings in V, 0.1nA resolution
+       *  - average of several readings for the lowest currents
+       *  - U_Rl is in V now (< 65mV)
+       */
+
+      Bits = LEAK_BITS;
+      if (U_Rl < LEAK_RANGE_U / 10) Runs = LEAK_RUNS;
+
+      Step = 0;
+      for (n = 0; n < Runs; n++)
+      {
+        wdt_reset();                    /* reset watchdog */
+        Step += ReadU_uV(Probes.Ch_2, Bits);
+      }
+      U_Rl = (uint16_t)(Step / Runs);   /* voltage at Rh (V) */
+
+      Scale = -10;                      /* 100p */
+      Value = 10000;                    /* scale voltage to 100 pV */
+    }
+#endif
   }
 
   /* clean up */
@@ -211,6 +250,35 @@ void GetLeakageCurrent(uint8_t Mode)
   R_DDR = 0;             /* set resistor port to HiZ mode */
   R_PORT = 0;            /* set resistor port low */
 
+#ifdef SW_LEAK_RANGING
+  /*
+   *  uncertainty: one ADC step of the reading
+   *  - reference: bandgap for low voltages (auto-scaling), Vcc otherwise
+   *  - in mV or V (like U_Rl)
+   */
+
+  Step = Cfg.Vcc;                       /* Vcc */
+  if (Cfg.AutoScale && ((Bits > 0) || (U_Rl < 1000)))
+    Step = Cfg.Bandgap;                 /* bandgap */
+
+  if (Bits > 0)                         /* integrated (V) */
+  {
+    Step *= 1000;                       /* mV -> V */
+    Step >>= (10 + Bits);               /* / 2^(10 + n) */
+    if (Runs > 1) Step /= 2;            /* averaged 4 readings */
+  }
+  else                                  /* single reading (mV) */
+  {
+    Step += 512;                        /* for rounding */
+    Step /= 1024;                       /* / 2^10 */
+  }
+
+  Step *= Value;                        /* scale voltage */
+  Step /= R_Shunt;                      /* I = U/R */
+  if (Step == 0) Step = 1;              /* at least one digit */
+  Semi.I_error = (uint16_t)Step;
+#endif
+
   /* calculate current */
   Value *= U_Rl;                   /* scale voltage */
   Value /= R_Shunt;                /* I = U/R */
@@ -261,6 +329,41 @@ Diode_Type *SearchDiode(uint8_t A, uint8_t C)
 }
 
 
+#ifdef ADC_OVERSAMPLING
+
+/*
+ *  get voltage across diode using oversampling
+ *  - waits 5ms for settling (like ReadU_5ms())
+ *  - 12 bit resolution (16 readings) for each side
+ *
+ *  requires:
+ *  - Anode: ADC MUX input channel of anode
+ *  - Cathode: ADC MUX input channel of cathode
+ *
+ *  returns:
+ *  - voltage in mV (rounded, 0 for negative voltages)
+ */
+
+uint16_t GetDiodeVoltage(uint8_t Anode, uint8_t Cathode)
+{
+  int32_t           U;             /* voltage in V */
+
+  wait5ms();                       /* settle time */
+  U = ReadU_uV(Anode, 2);          /* get voltage at anode */
+  U -= ReadU_uV(Cathode, 2);       /* substract voltage at cathode */
+
+  if (U < 0)                       /* prevent underrun */
+    U = 0;
+
+  U += 500;                        /* rounding */
+  U /= 1000;                       /* V -> mV */
+
+  return (uint16_t)U;
+}
+
+#endif // ADC_OVERSAMPLING
+
+
 /*
  *  check for diode
  */
@@ -339,8 +442,12 @@ void CheckDiode(void)
   R_DDR = Probes.Rl_1;                  /* enable Rl for probe-1 */
   R_PORT = Probes.Rl_1;                 /* pull up anode via Rl */
   PullProbe(Probes.Rl_3, PULL_10MS | PULL_UP);     /* discharge gate */
+#ifdef ADC_OVERSAMPLING
+  U1_Rl = GetDiodeVoltage(Probes.Ch_1, Probes.Ch_2);
+#else
   U1_Rl = ReadU_5ms(Probes.Ch_1);       /* get voltage at anode */
   U1_Rl -= ReadU(Probes.Ch_2);          /* substract voltage at cathode */
+#endif
 
   DischargeProbes();                    /* try to discharge probes */
   if (Check.Found == COMP_ERROR)
@@ -365,19 +472,27 @@ void CheckDiode(void)
   R_PORT = 0;                           /* pull down cathode via Rh */
   R_DDR = Probes.Rh_2;                  /* enable Rh for probe-2 */
   PullProbe(Probes.Rl_3, PULL_10MS | PULL_DOWN);   /* discharge gate */
+#ifdef ADC_OVERSAMPLING
+  U2_Rh = GetDiodeVoltage(Probes.Ch_1, Probes.Ch_2);
+#else
   U2_Rh = ReadU_5ms(Probes.Ch_1);       /* get voltage at anode */
   U_Diff = ReadU(Probes.Ch_2);          /* get voltage at cathode */
   if (U2_Rh >= U_Diff)                  /* prevent underrun */
     U2_Rh -= U_Diff;                    /* V_f = U_Anode - U_Cathode */
   else                                  /* maybe large inductance */
     U2_Rh = 0;                          /* simply zero */
+#endif
 
   /* measure voltage across DUT (Vf) with Rl */
   /* set probes: Gnd -- Rl -- probe-2 / probe-1 -- Vcc */
   R_DDR = Probes.Rl_2;                  /* pull down cathode via Rl */
   PullProbe(Probes.Rl_3, PULL_10MS | PULL_DOWN);   /* discharge gate */
+#ifdef ADC_OVERSAMPLING
+  U2_Rl = GetDiodeVoltage(Probes.Ch_1, Probes.Ch_2);
+#else
   U2_Rl = ReadU_5ms(Probes.Ch_1);       /* get voltage at anode */
   U2_Rl -= ReadU(Probes.Ch_2);          /* substract voltage at cathode */
+#endif
 
   ADC_DDR = 0;                     /* stop pulling up */
 
@@ -547,6 +662,10 @@ void GetGateThreshold(uint8_t Type)
   uint8_t           Drain_ADC;     /* ADC port register bits for drain */
   uint8_t           PullMode;      /* pull-up/down mode */
   uint8_t           Counter;       /* loop counter */
+#ifdef SW_VTH_TRACKING
+  uint16_t          Min = UINT16_MAX;   /* min. ADC reading */
+  uint16_t          Max = 0;            /* max. ADC reading */
+#endif
 
   /*
    *  init variables
@@ -581,6 +700,9 @@ void GetGateThreshold(uint8_t Type)
   Drain_ADC &= ((1 << TP1) | (1 << TP2) | (1 << TP3));
   ADMUX = Probes.Ch_3 | ADC_REF_VCC;    /* select probe-3 for ADC input */
                                         /* and use Vcc as reference */
+#ifdef ADC_STATE_CACHE
+  ADC_State.Flags &= ~ADC_STATE_VALID;   /* ADC state unknown */
+#endif
 #ifndef ADC_LARGE_BUFFER_CAP
     /* buffer cap: 1nF or none at all */
     wait100us();                   /* time for voltage stabilization */
@@ -594,8 +716,46 @@ void GetGateThreshold(uint8_t Type)
   {
     wdt_reset();                         /* reset watchdog */
 
+#ifdef SW_VTH_TRACKING
+    if (Counter == 0)                   /* first run */
+    {
+      /* discharge gate via Rl for 10 ms */
+      PullProbe(Probes.Rl_3, PullMode);
+    }
+    else                                /* next runs */
+    {
+      /*
+       *  discharge gate via Rl just until FET stops conducting
+       *  - gate stays close to V_th, so charging via Rh takes only
+       *    a fraction of the time needed from 0V
+       *  - any problem will cause a watchdog timeout
+       */
+
+      if (Type & TYPE_N_CHANNEL)        /* n-channel */
+      {
+        R_DDR = Drain_Rl | Probes.Rl_3;      /* pull down gate via Rl */
+
+        /* FET stops conducting when the drain reaches high level */
+        while (!(ADC_PIN & Drain_ADC))
+          /* nop */ ;
+      }
+      else                              /* p-channel */
+      {
+        R_PORT |= Probes.Rl_3;               /* pull up gate via Rl */
+        R_DDR = Drain_Rl | Probes.Rl_3;
+
+        /* FET stops conducting when the drain reaches low level */
+        while (ADC_PIN & Drain_ADC)
+          /* nop */ ;
+
+        R_DDR = Drain_Rl;                    /* set probe-3 to HiZ mode */
+        R_PORT &= ~Probes.Rl_3;              /* reset pull-up */
+      }
+    }
+#else
     /* discharge gate via Rl for 10 ms */
     PullProbe(Probes.Rl_3, PullMode);
+#endif
 
     /* pull up/down gate via Rh to slowly charge gate */
     R_DDR = Drain_Rl | Probes.Rh_3;
@@ -627,10 +787,28 @@ void GetGateThreshold(uint8_t Type)
     else                                /* p-channel */
       Ugs -= (1023 - ADCW);               /* Ugs = - (Vcc - U_g) */
 //      todo LGT!!!!!
+
+#ifdef SW_VTH_TRACKING
+    /* stop early when readings are stable */
+    if (ADCW < Min) Min = ADCW;
+    if (ADCW > Max) Max = ADCW;
+    if ((Counter >= VTH_MIN_SAMPLES - 1) && (Max - Min <= VTH_SPREAD))
+    {
+      Counter++;                        /* number of samples */
+      break;                            /* end loop */
+    }
+#endif
   }
 
+#ifdef SW_VTH_TRACKING
+  Semi.Runs = Counter;           /* save number of samples */
+
+  /* calculate V_th */
+  Ugs /= Counter;                /* average of samples */
+#else
   /* calculate V_th */
   Ugs /= 10;                     /* average of 10 samples */
+#endif
   Ugs *= Cfg.Vcc;                /* convert to voltage */
   Ugs /= 1024;                   /* using 10 bit resolution */
 //  todo LGT!!!!!
@@ -884,6 +1062,250 @@ uint32_t Get_hFE_C(uint8_t Type)
 }
 
 
+#ifdef SW_HFE_SWEEP
+
+/*
+ *  get current through Rl or Rh
+ *
+ *  requires:
+ *  - U_R: voltage across resistor (mV)
+ *  - Ri: internal resistance of MCU for Rl (0.1 Ohms)
+ *        0 for Rh
+ *
+ *  returns:
+ *  - current (nA)
+ */
+
+uint32_t Get_hFE_Current(uint16_t U_R, uint16_t Ri)
+{
+  uint32_t          I;             /* return value */
+
+  I = U_R;
+  I *= 100000;                     /* scale to 0.01 V */
+
+  if (Ri)                          /* Rl */
+  {
+    I /= (R_LOW * 10) + Ri;        /* / (Rl + Ri) in 0.1 Ohms -> 100 nA */
+    I *= 100;                      /* 100 nA -> nA */
+  }
+  else                             /* Rh */
+  {
+    I /= R_HIGH / 10;              /* / 10 Ohms -> nA */
+  }
+
+  return I;
+}
+
+
+/*
+ *  measure hFE of BJT at several operating points
+ *  - common emitter and common collector circuit, each with Rl or Rh
+ *    as base resistor and as collector/emitter resistor
+ *  - common emitter circuit also with Rl as emitter resistor
+ *    (emitter degeneration, lowers I_B and I_C)
+ *  - skips points with a saturated BJT or a voltage across a resistor
+ *    too low for a reasonable resolution
+ *  - skips points with about the same I_C/I_E as a point already found
+ *  - uses Semi.A/B/C and Check.Type of the detected BJT
+ *
+ *  sets:
+ *  - hFE_Points[]: points sorted by I_C/I_E
+ *  - hFE_Count: number of points
+ */
+
+void Get_hFE_Sweep(void)
+{
+  uint8_t           Num = 0;       /* number of points */
+  uint8_t           Mode;          /* drive mode */
+  uint8_t           n;             /* counter */
+  uint8_t           Pos;           /* position of point */
+  uint8_t           Direct;        /* pin mask for direct connection */
+  uint8_t           Load;          /* resistor mask for collector/emitter */
+  uint8_t           Base;          /* resistor mask for base */
+  uint8_t           Emitter;       /* resistor mask for emitter */
+  uint8_t           Port_ADC;      /* ADC port */
+  uint8_t           Port_R;        /* resistor port */
+  uint8_t           Channel;       /* ADC channel of collector/emitter */
+  uint16_t          U_x;           /* voltage at collector/emitter */
+  uint16_t          U_b;           /* voltage at base */
+  uint16_t          Ri_Up;         /* internal resistance for pull-up */
+  uint16_t          Ri_Down;       /* internal resistance for pull-down */
+  uint32_t          Diff;          /* min. difference of I_C/I_E */
+  hFE_Point_Type    Point;         /* operating point */
+
+  /* we assume: probe-1 = C / probe-2 = E / probe-3 = B */
+  UpdateProbes(Semi.B, Semi.C, Semi.A);
+
+  if (Check.Type & TYPE_NPN)       /* NPN */
+  {
+    Ri_Up = NV.RiH;
+    Ri_Down = NV.RiL;
+  }
+  else                             /* PNP */
+  {
+    Ri_Up = NV.RiL;
+    Ri_Down = NV.RiH;
+  }
+
+  for (Mode = 0; Mode < HFE_SWEEP_MODES; Mode++)
+  {
+    wdt_reset();                   /* reset watchdog */
+
+    /*
+     *  set up probes for NPN
+     *  - CE: Gnd -- emitter / collector -- R -- Vcc / base -- R -- Vcc
+     *  - CE with emitter resistor: Gnd -- Rl -- emitter
+     *  - CC: Gnd -- R -- emitter / collector -- Vcc / base -- R -- Vcc
+     */
+
+    if (Mode & HFE_SWEEP_RB_RL) Base = Probes.Rl_3;
+    else Base = Probes.Rh_3;
+
+    Emitter = 0;                   /* no emitter resistor */
+
+    if (Mode & HFE_SWEEP_CC)       /* common collector */
+    {
+      if (Mode & HFE_SWEEP_RE)
+        continue;                  /* load is emitter resistor already */
+
+      if (Mode & HFE_SWEEP_RX_RL) Load = Probes.Rl_2;
+      else Load = Probes.Rh_2;
+
+      Direct = Probes.Pin_1;       /* collector */
+      Port_ADC = Probes.Pin_1;     /* pull up collector */
+      Port_R = Base;               /* pull up base, pull down emitter */
+      Channel = Probes.Ch_2;       /* emitter */
+    }
+    else                           /* common emitter */
+    {
+      if (Mode & HFE_SWEEP_RX_RL) Load = Probes.Rl_1;
+      else Load = Probes.Rh_1;
+
+      if (Mode & HFE_SWEEP_RE)     /* emitter resistor */
+      {
+        Emitter = Probes.Rl_2;     /* pull down emitter via Rl */
+        Direct = 0;
+      }
+      else                         /* emitter to Gnd */
+      {
+        Direct = Probes.Pin_2;     /* emitter */
+      }
+
+      Port_ADC = 0;                /* pull down emitter */
+      Port_R = Load | Base;        /* pull up collector and base */
+      Channel = Probes.Ch_1;       /* collector */
+    }
+
+    /* PNP: reversed polarity */
+    if (Check.Type & TYPE_PNP)
+    {
+      Port_ADC ^= Direct;
+      Port_R ^= Load | Base | Emitter;
+    }
+
+    ADC_PORT = Port_ADC;
+    ADC_DDR = Direct;
+    R_PORT = Port_R;
+    R_DDR = Load | Base | Emitter;
+
+    /* get voltages */
+    U_x = ReadU_5ms(Channel);
+    U_b = ReadU(Probes.Ch_3);
+    if (U_x > Cfg.Vcc) U_x = Cfg.Vcc;
+    if (U_b > Cfg.Vcc) U_b = Cfg.Vcc;
+
+    /* PNP: mirror voltages to match NPN */
+    if (Check.Type & TYPE_PNP)
+    {
+      U_x = Cfg.Vcc - U_x;
+      U_b = Cfg.Vcc - U_b;
+    }
+
+    /*
+     *  voltages across resistors
+     *  - CE: U_R_c = Vcc - U_c
+     *  - CC: U_R_e = U_e
+     *  - U_R_b = Vcc - U_b
+     */
+
+    if (! (Mode & HFE_SWEEP_CC))   /* common emitter */
+    {
+      if (U_x <= U_b) continue;    /* saturated (U_c <= U_b) */
+      U_x = Cfg.Vcc - U_x;
+    }
+    U_b = Cfg.Vcc - U_b;
+
+    if ((U_x < HFE_SWEEP_MIN_U) || (U_b < HFE_SWEEP_MIN_U))
+      continue;                    /* too low */
+
+    /* get currents */
+    if (Mode & HFE_SWEEP_RB_RL)    /* Rl */
+      Point.I_b = Get_hFE_Current(U_b, Ri_Up);
+    else                           /* Rh */
+      Point.I_b = Get_hFE_Current(U_b, 0);
+
+    if (Mode & HFE_SWEEP_RX_RL)    /* Rl */
+    {
+      if (Mode & HFE_SWEEP_CC)     /* pull-down */
+        Point.I_x = Get_hFE_Current(U_x, Ri_Down);
+      else                         /* pull-up */
+        Point.I_x = Get_hFE_Current(U_x, Ri_Up);
+    }
+    else                           /* Rh */
+      Point.I_x = Get_hFE_Current(U_x, 0);
+
+    if (Point.I_b == 0)
+      continue;                    /* prevent division by zero */
+
+    /*
+     *  hFE
+     *  - CE: hFE = I_c / I_b
+     *  - CC: hFE = (I_e - I_b) / I_b
+     */
+
+    Point.hFE = Point.I_x;
+    if ((Mode & HFE_SWEEP_CC) && (Point.hFE > Point.I_b))
+      Point.hFE -= Point.I_b;
+    Point.hFE /= Point.I_b;
+    Point.Mode = Mode;
+
+    /* find position sorted by I_C/I_E */
+    Pos = Num;
+    while ((Pos > 0) && (hFE_Points[Pos - 1].I_x > Point.I_x))
+    {
+      Pos--;
+    }
+
+    /* skip point with about the same I_C/I_E as a neighbour */
+    Diff = Point.I_x / HFE_SWEEP_MIN_DIFF;
+    if ((Pos > 0) && (Point.I_x - hFE_Points[Pos - 1].I_x < Diff))
+      continue;                    /* same as lower neighbour */
+    if ((Pos < Num) && (hFE_Points[Pos].I_x - Point.I_x < Diff))
+      continue;                    /* same as upper neighbour */
+
+    /* insert point */
+    n = Num;
+    while (n > Pos)
+    {
+      hFE_Points[n] = hFE_Points[n - 1];
+      n--;
+    }
+    hFE_Points[Pos] = Point;
+    Num++;
+  }
+
+  /* reset probes */
+  R_DDR = 0;
+  R_PORT = 0;
+  ADC_DDR = 0;
+  ADC_PORT = 0;
+
+  hFE_Count = Num;                 /* save number of points */
+}
+
+#endif // SW_HFE_SWEEP
+
+
 /*
  *  check for BJT, enhancement-mode MOSFET and IGBT
  *  - sets hFE test circuit type in Semi.Flags
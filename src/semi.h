@@ -37,6 +37,65 @@
 #define HFE_CIRCUIT_MASK      0b00000011     /* mask for hFE circuit flags */
 
 
+#ifdef SW_LEAK_RANGING
+
+#ifndef ADC_OVERSAMPLING
+#error <<< Leakage ranging requires ADC_OVERSAMPLING >>>
+#endif
+
+/* leakage current: max. voltage at Rh for integration (mV, < 65) */
+#define LEAK_RANGE_U          50
+
+/* leakage current: additional ADC resolution for integration */
+#define LEAK_BITS             3
+
+/* leakage current: number of readings below LEAK_RANGE_U / 10 */
+#define LEAK_RUNS             4
+
+#endif
+
+
+#ifdef SW_VTH_TRACKING
+
+/* gate threshold: min. number of samples */
+#define VTH_MIN_SAMPLES       4
+
+/* gate threshold: max. spread of stable ADC readings */
+#define VTH_SPREAD            2
+
+#endif
+
+
+#ifdef SW_HFE_SWEEP
+
+#ifndef UI_SERIAL_COPY
+#error <<< hFE sweep requires UI_SERIAL_COPY >>>
+#endif
+
+/* drive modes for hFE sweep (bitfield) */
+#define HFE_SWEEP_CC          0b00000001     /* common collector (otherwise common emitter) */
+#define HFE_SWEEP_RB_RL       0b00000010     /* base resistor: Rl (otherwise Rh) */
+#define HFE_SWEEP_RX_RL       0b00000100     /* collector/emitter resistor: Rl (otherwise Rh) */
+#define HFE_SWEEP_RE          0b00001000     /* common emitter: Rl as emitter resistor */
+
+/* number of drive modes */
+#define HFE_SWEEP_MODES       16
+
+/* max. number of points (no emitter resistor for common collector) */
+#define HFE_SWEEP_POINTS      12
+
+/* min. voltage across resistors (mV) */
+#define HFE_SWEEP_MIN_U       50
+
+/* min. difference of I_C/I_E for a distinct point (1/n) */
+#define HFE_SWEEP_MIN_DIFF    16
+
+/* min. number of distinct points for a usable sweep */
+#define HFE_SWEEP_MIN_POINTS  3
+
+#endif
+
+
 /* flags for semicondutor detection logic (bitfield) */
 #define DONE_NONE             0b00000000     /* detected nothing / not sure yet */
 #define DONE_SEMI             0b00000001     /* detected semi */
@@ -69,6 +128,12 @@ typedef struct
   #ifdef SW_REVERSE_HFE
   uint32_t          F_2;           /* factor #2 */
   #endif
+  #ifdef SW_VTH_TRACKING
+  uint8_t           Runs;          /* number of measurement runs */
+  #endif
+  #ifdef SW_LEAK_RANGING
+  uint16_t          I_error;       /* uncertainty of current (I_scale) */
+  #endif
   uint32_t          I_value;       /* current */
   int8_t            I_scale;       /* exponent of factor (value * 10^x) */
   uint32_t          C_value;       /* capacitance */
@@ -88,8 +153,10 @@ typedef struct
   U_3      I_C/E (A)   V_GS(off)
   F_1      hFE                                    MT2 (mV)
   F_2      hFEr
+  Runs                  V_th runs                              V_th runs
   I_value  I_CEO        I_DSS
   I_scale  I_CEO        I_DSS
+  I_error  I_CEO
   C_value  C_EB/BE
   C_scale  C_EB/BE
 
@@ -98,6 +165,19 @@ typedef struct
   U_1      V_Z (mV)
 */
 
+#ifdef SW_HFE_SWEEP
+
+/* operating point of hFE sweep */
+typedef struct
+{
+  uint32_t          I_x;           /* I_C or I_E (nA) */
+  uint32_t          I_b;           /* I_B (nA) */
+  uint32_t          hFE;           /* hFE */
+  uint8_t           Mode;          /* drive mode */
+} hFE_Point_Type;
+
+#endif
+
 /* special semiconductors */
 typedef struct
 {
@@ -127,10 +207,17 @@ extern uint32_t Get_hfe_c(uint8_t Type);
 extern void GetLeakageCurrent(uint8_t Mode);
 
 extern Diode_Type *SearchDiode(uint8_t A, uint8_t C);
+#ifdef ADC_OVERSAMPLING
+extern uint16_t GetDiodeVoltage(uint8_t Anode, uint8_t Cathode);
+#endif
 extern void CheckDiode(void);
 
 extern void VerifyMOSFET(void);
 extern void CheckTransistor(uint8_t BJT_Type, uint16_t U_Rl);
+#ifdef SW_HFE_SWEEP
+extern uint32_t Get_hFE_Current(uint16_t U_R, uint16_t Ri);
+extern void Get_hFE_Sweep(void);
+#endif
 extern void CheckDepletionModeFET(uint16_t U_Rl);
 
 extern uint8_t CheckThyristorTriac(void);
@@ -153,6 +240,11 @@ extern Diode_Type      Diodes[];           /* diodes */
 extern Semi_Type       Semi;               /* common semiconductor */
 extern AltSemi_Type    AltSemi;            /* special semiconductor */
 
+#ifdef SW_HFE_SWEEP
+extern hFE_Point_Type  hFE_Points[];       /* hFE sweep */
+extern uint8_t         hFE_Count;          /* number of points */
+#endif
+
 #ifdef SW_HFE_CURRENT
 extern const unsigned char I_str[]; 
 #endif
@@ -28,6 +28,17 @@
 const unsigned char ESR_str[] MEM_TYPE = "ESR";
 #endif
 
+#ifdef SW_CAP_LEAKAGE_LOG
+const unsigned char CapTrend_str[] MEM_TYPE = "Trend";
+
+volatile uint8_t    CapLog_Ticks;       /* seconds (Timer1 ISR) */
+#endif
+
+#ifdef SW_CAP_DA
+const unsigned char CapDA_DA_str[] MEM_TYPE = "DA";
+const unsigned char CapDA_Tau_str[] MEM_TYPE = "tau";
+#endif
+
 
 /* ************************************************************************
  *   ESR tool
@@ -35,6 +46,104 @@ const unsigned char ESR_str[] MEM_TYPE = "ESR";
 
 #ifdef SW_ESR_TOOL
 
+#ifdef SW_ESR_STREAM
+
+/*
+ *  stream ESR
+ *  - runs ESR pulses in batches of ESR_STREAM_PULSES and keeps the sums
+ *    of the last ESR_STREAM_SLOTS batches in a ring buffer
+ *  - Timer1 paces the output of the rolling ESR
+ *  - runs until key is pressed
+ *
+ *  requires:
+ *  - Cap: pointer to cap data structure
+ */
+
+void ESR_Stream(Capacitor_Type *Cap)
+{
+  ESR_Type          ESR;                /* ESR measurement state */
+  uint16_t          Ring_1[ESR_STREAM_SLOTS];    /* sums without DUT */
+  uint16_t          Ring_2[ESR_STREAM_SLOTS];    /* sums with DUT */
+  uint32_t          Sum_1 = 1;          /* rolling sum without DUT */
+  uint32_t          Sum_2 = 1;          /* rolling sum with DUT */
+  uint8_t           Slot = 0;           /* slot of ring buffer */
+  uint8_t           n;                  /* counter */
+  uint16_t          Value;              /* ESR (in 0.01 Ohms) */
+
+  if (ESR_Setup(Cap, &ESR) == 0)
+    return;              /* skip on error */
+
+  /* clear ring buffer */
+  for (n = 0; n < ESR_STREAM_SLOTS; n++)
+  {
+    Ring_1[n] = 0;
+    Ring_2[n] = 0;
+  }
+
+  /*
+   *  set up Timer1:
+   *  - CTC mode (count up to OCR1A)
+   *  - prescaler 1024
+   */
+
+  TCCR1B = 0;                           /* stop timer */
+  TCCR1A = 0;                           /* normal port operation */
+  TCNT1 = 0;                            /* reset counter */
+  OCR1A = ESR_STREAM_TOP;               /* output rate */
+  TIFR1 = (1 << OCF1A);                 /* clear flag */
+  TCCR1B = (1 << WGM12) | (1 << CS12) | (1 << CS10);   /* start timer */
+
+  while (BUTTON_PIN & (1 << TEST_BUTTON))    /* as long as key isn't pressed */
+  {
+    wdt_reset();                        /* reset watchdog */
+
+    /* run next batch */
+    ESR.Sum_1 = 0;
+    ESR.Sum_2 = 0;
+    ESR_Pulses(&ESR, ESR_STREAM_PULSES);
+
+    /* replace oldest batch in ring buffer (sums fit into 16 bits) */
+    Sum_1 -= Ring_1[Slot];
+    Sum_1 += ESR.Sum_1;
+    Ring_1[Slot] = (uint16_t)ESR.Sum_1;
+    Sum_2 -= Ring_2[Slot];
+    Sum_2 += ESR.Sum_2;
+    Ring_2[Slot] = (uint16_t)ESR.Sum_2;
+    Slot++;                             /* next slot */
+    Slot &= ESR_STREAM_SLOTS - 1;       /* wrap around */
+
+    if (TIFR1 & (1 << OCF1A))           /* time for output */
+    {
+      TIFR1 = (1 << OCF1A);             /* clear flag */
+
+      /* show capacitance and rolling ESR */
+      LCD_ClearLine2();
+      Display_Value(Cap->Value, Cap->Scale, 'F');
+      Display_Space();
+#ifdef UI_SERIAL_COPY
+      Cfg.OP_Control |= OP_OUT_SER;     /* copy ESR to serial */
+#endif
+      Value = ESR_Value(Cap, Sum_1, Sum_2);
+      if (Value != UINT16_MAX)          /* got valid ESR */
+        Display_Value(Value, -2, LCD_CHAR_OMEGA);
+      else                              /* no ESR */
+        Display_Minus();
+#ifdef UI_SERIAL_COPY
+      Display_Serial_Off();             /* disable serial output & NL */
+#endif
+    }
+  }
+
+  TCCR1B = 0;                           /* stop timer */
+
+  /* wait until key is released */
+  while (!(BUTTON_PIN & (1 << TEST_BUTTON)));
+  MilliSleep(50);                       /* time to debounce */
+}
+
+#endif // SW_ESR_STREAM
+
+
 /*
  *  ESR tool
  *  - uses probe #1 (pos) and probe #3 (neg)
@@ -106,7 +215,12 @@ void ESR_Tool(void)
       Display_Space();
       ESR = MeasureESR(Cap);
       if (ESR != UINT16_MAX)           /* got valid ESR */
+      {
         Display_Value(ESR, -2, LCD_CHAR_OMEGA);
+#ifdef SW_ESR_STREAM
+        ESR_Stream(Cap);               /* keep on measuring ESR */
+#endif
+      }
       else                            /* no ESR */
         Display_Minus();
     }
@@ -128,6 +242,166 @@ void ESR_Tool(void)
 
 #ifdef SW_CAP_LEAKAGE
 
+#ifdef SW_CAP_LEAKAGE_LOG
+
+/*
+ *  ISR for match of Timer1's ICR1 (top)
+ *  - one tick per second
+ */
+
+ISR(TIMER1_CAPT_vect, ISR_BLOCK)
+{
+  /*
+   *  hints:
+   *  - the ICF1 interrupt flag is cleared automatically
+   *  - interrupt processing is disabled while this ISR runs
+   *    (no nested interrupts)
+   */
+
+  CapLog_Ticks++;                       /* got another second */
+
+  /* break TestKey() processing */
+  Cfg.OP_Control |= OP_BREAK_KEY;       /* set break signal */
+}
+
+
+/*
+ *  get log code of a current
+ *  - binary logarithm with 8 fractional bits
+ *
+ *  requires:
+ *  - Current: current in 0.1nA (> 0)
+ *
+ *  returns:
+ *  - log2(Current) * 256
+ */
+
+uint16_t CapLog_Code(uint32_t Current)
+{
+  uint16_t          Code = 0;           /* return value */
+
+  /* reduce to 16 bits */
+  while (Current > UINT16_MAX)
+  {
+    Current >>= 1;                      /* /2 */
+    Code += 256;                        /* +1 for log2 */
+  }
+
+  Code += Log2Value((uint16_t)Current);
+
+  return Code;
+}
+
+
+/*
+ *  add sample to leakage log
+ *  - takes a sample every CAP_LOG_INTERVAL seconds
+ *  - ring buffer of deltas to the preceding sample
+ *  - copies sample to serial
+ *
+ *  requires:
+ *  - Log: pointer to log
+ *  - Time: time since start of charging (in s)
+ *  - Current: current in 0.1nA (> 0)
+ */
+
+void CapLog_Sample(CapLog_Type *Log, uint16_t Time, uint32_t Current)
+{
+  int16_t           Delta;              /* delta to last sample */
+  uint8_t           n;                  /* slot */
+
+  if (Log->Count && (Time - Log->Time < CAP_LOG_INTERVAL))
+    return;                             /* not due yet */
+
+  Log->Time = Time;                     /* time of sample */
+  Delta = CapLog_Code(Current);         /* log code of current */
+
+  if (Log->Count == 0)                  /* first sample */
+  {
+    Log->First = Delta;
+    Log->Last = Delta;
+    Log->Count = 1;
+  }
+  else                                  /* next sample */
+  {
+    /* delta to last sample (saturating) */
+    Delta -= Log->Last;
+    if (Delta > INT8_MAX) Delta = INT8_MAX;
+    else if (Delta < INT8_MIN) Delta = INT8_MIN;
+    Log->Last += Delta;                 /* keep reconstructed value */
+
+    if (Log->Count > CAP_LOG_SIZE)      /* ring buffer is full */
+    {
+      /* drop oldest sample */
+      Log->First += Log->Delta[Log->Head];
+      Log->Head++;                      /* next slot */
+      if (Log->Head >= CAP_LOG_SIZE) Log->Head = 0;
+      Log->Count--;
+    }
+
+    n = Log->Head + Log->Count - 1;     /* free slot */
+    if (n >= CAP_LOG_SIZE) n -= CAP_LOG_SIZE;
+    Log->Delta[n] = (int8_t)Delta;
+    Log->Count++;
+  }
+
+#ifdef UI_SERIAL_COPY
+  /* serial: time and current */
+  Cfg.OP_Control &= ~OP_OUT_LCD;        /* disable display output */
+  Cfg.OP_Control |= OP_OUT_SER;         /* enable serial output */
+  Display_Value(Time, 0, 's');
+  Display_Space();
+  Display_Value(Current, -10, 'A');
+  Serial_NewLine();                     /* serial: new line */
+  Cfg.OP_Control &= ~OP_OUT_SER;        /* disable serial output */
+  Cfg.OP_Control |= OP_OUT_LCD;         /* enable display output */
+#endif
+}
+
+
+/*
+ *  display trend of leakage log in line #4
+ *  - time span and change of current in dB
+ *  - as text on all displays, since the only box drawing function
+ *    (LCD_Box()) is part of the color code support of the color
+ *    graphic drivers and compiled only with the resistor color code
+ *    options (FUNC_COLORCODE)
+ *
+ *  requires:
+ *  - Log: pointer to log
+ */
+
+void CapLog_Show(CapLog_Type *Log)
+{
+  int32_t           Value;              /* change in 0.1dB */
+
+  if (UI.CharMax_Y < 4) return;         /* display too small */
+
+  LCD_ClearLine(4);                     /* clear line #4 */
+  LCD_CharPos(1, 4);                    /* go to start of line #4 */
+  Display_EEString_Space(CapTrend_str); /* display: Trend */
+
+  if (Log->Count > 1)                   /* got samples to compare */
+  {
+    /* time span */
+    Value = (Log->Count - 1) * CAP_LOG_INTERVAL;
+    Display_Value(Value, 0, 's');
+    Display_Space();
+
+    /* change: 20 * log10(2) = 6.02dB per step of log2 */
+    Value = Log->Last - Log->First;     /* log2 * 256 */
+    Value *= 602;
+    Value /= 2560;                      /* 0.1dB */
+    Display_SignedFullValue(Value, 1, 'd');
+    Display_Char('B');
+  }
+  else                                  /* not enough samples */
+    Display_Minus();
+}
+
+#endif // SW_CAP_LEAKAGE_LOG
+
+
 /*
  *  tool for measuring the leakage current of a capacitor
  *  - uses probe #1 (pos) and probe #3 (neg)
@@ -140,6 +414,12 @@ void Cap_Leakage(void)
   uint8_t           Mode;               /* mode */
   uint16_t          U1;                 /* voltage #1 */
   uint32_t          Value;              /* temp. value */
+#ifdef SW_CAP_LEAKAGE_LOG
+  uint32_t          Current = 0;        /* current (in 0.1nA) */
+  uint16_t          Time = 0;           /* time since start of charging (in s) */
+  uint8_t           Ticks;              /* last tick counter */
+  CapLog_Type       Log;                /* leakage log */
+#endif
 
   /* local constants for Mode */
   #define MODE_PINOUT         0         /* show pinout */
@@ -162,8 +442,34 @@ void Cap_Leakage(void)
 
   UpdateProbes(PROBE_1, 0, PROBE_3);    /* update register bits and probes */
 
+#ifdef SW_CAP_LEAKAGE_LOG
+  /*
+   *  set up Timer1:
+   *  - CTC mode (count up to ICR1)
+   *  - prescaler 1024
+   *  - one tick per second via ISR
+   */
+
+  Log.Count = 0;                        /* empty log */
+  Ticks = CapLog_Ticks;
+  TCCR1B = 0;                           /* stop timer */
+  TCCR1A = 0;                           /* normal port operation */
+  TCNT1 = 0;                            /* reset counter */
+  ICR1 = (F_CPU / 1024) - 1;            /* 1s */
+  TIFR1 = (1 << ICF1);                  /* clear flag */
+  TIMSK1 = (1 << ICIE1);                /* enable interrupt */
+  TCCR1B = (1 << WGM13) | (1 << WGM12) | (1 << CS12) | (1 << CS10);
+#endif
+
   while (1)       /* processing loop */
   {
+#ifdef SW_CAP_LEAKAGE_LOG
+    /* update time */
+    Test = CapLog_Ticks;                /* get ticks */
+    Time += (uint8_t)(Test - Ticks);    /* add elapsed seconds */
+    Ticks = Test;
+#endif
+
     /*
      *  display mode and set probes
      */
@@ -179,6 +485,13 @@ void Cap_Leakage(void)
           Display_EEString_Space(CapCharge_str);
           Display_EEString(CapHigh_str);
 
+#ifdef SW_CAP_LEAKAGE_LOG
+          /* start new log */
+          Log.Count = 0;                /* empty log */
+          Log.Head = 0;
+          Time = 0;                     /* reset time */
+#endif
+
           /* set probes: probe-3 -- Rl -- Gnd / probe-1 -- Vcc */
           ADC_DDR = 0;                  /* set to HiZ */
           R_DDR = Probes.Rl_3;          /* select Rl for probe-3 */
@@ -242,6 +555,9 @@ void Cap_Leakage(void)
             Value *= 100000;                   /* scale to 0.01 V */
             Value /= ((R_LOW * 10) + NV.RiL);  /* 0.01 V / 0.1 Ohms = 0.1 A */
             Display_Value(Value, -7, 'A');     /* display current */
+#ifdef SW_CAP_LEAKAGE_LOG
+            Current = Value * 1000;            /* 0.1 nA */
+#endif
 
             /* change to low current mode when current is quite low */
             if (U1 <= 3)                       /* I <= 4.2A */
@@ -259,9 +575,17 @@ void Cap_Leakage(void)
               Value *= 10000;                    /* scale to 0.1 V */
               Value /= (R_HIGH / 1000);          /* 0.1 V / kOhms = 0.1 nA */
               Display_Value(Value, -10, 'A');    /* display current */
+#ifdef SW_CAP_LEAKAGE_LOG
+              Current = Value;                   /* 0.1 nA */
+#endif
             }
             else                          /* in the noise floor */
+            {
               Display_Minus();
+#ifdef SW_CAP_LEAKAGE_LOG
+              Current = 0;                       /* no sample */
+#endif
+            }
         }
 
         /* common display output */
@@ -270,8 +594,29 @@ void Cap_Leakage(void)
         Display_Char('(');
         Display_Value(U1, -3, 'V');          /* display voltage */
         Display_Char(')');
+
+#ifdef SW_CAP_LEAKAGE_LOG
+        /* log current and show trend */
+        if (Current > 0)
+          CapLog_Sample(&Log, Time, Current);
+        CapLog_Show(&Log);
+#endif
       }
 
+#ifdef SW_CAP_LEAKAGE_LOG
+      /* wait for user feedback or next tick of Timer1 */
+skip:
+      Test = TestKey(0, CHECK_KEY_TWICE | CHECK_BAT);
+      /* also delay for next loop run */
+
+      if (Test == KEY_TWICE)
+      {
+        TCCR1B = 0;                     /* stop timer */
+        TIMSK1 = 0;                     /* disable all interrupts for Timer1 */
+        Cfg.OP_Control &= ~OP_BREAK_KEY;     /* clear break signal */
+        return;
+      }
+#else
       /* wait for user feedback or timeout of 2s */
 skip:
       Test = TestKey(2000, CHECK_KEY_TWICE | CHECK_BAT);
@@ -279,6 +624,7 @@ skip:
 
       if (Test == KEY_TWICE)
         return;
+#endif
 
       if (Test == KEY_SHORT            /* short key press */
 #if defined(HW_ENCODER) || defined(HW_INCDEC_KEYS) || defined(HW_TOUCH)
@@ -308,3 +654,281 @@ skip:
 
 
 #endif // SW_CAP_LEAKAGE
+
+
+/* ************************************************************************
+ *   dielectric absorption and self-discharge
+ * ************************************************************************ */
+
+#ifdef SW_CAP_DA
+
+/*
+ *  wait for next tick of Timer1 and read voltage at probe-1
+ *  - copies time and voltage to serial
+ *
+ *  requires:
+ *  - Phase: phase number (1-4)
+ *    1: charging (probe-3 via Rl), else probe-3 at Gnd
+ *  - Tick: pointer to tick counter
+ *
+ *  returns:
+ *  - voltage across cap in mV
+ *  - UINT16_MAX if key was pressed
+ */
+
+uint16_t CapDA_Read(uint8_t Phase, uint16_t *Tick)
+{
+  uint16_t          U;                  /* voltage */
+  uint16_t          Value;              /* temp. value */
+
+  while (! (TIFR1 & (1 << OCF1A)))      /* wait for tick */
+  {
+    if (! (BUTTON_PIN & (1 << TEST_BUTTON)))   /* key pressed */
+      return UINT16_MAX;
+  }
+
+  TIFR1 = (1 << OCF1A);                 /* clear flag */
+  wdt_reset();                          /* reset watchdog */
+  (*Tick)++;                            /* got another tick */
+
+  U = ReadU(Probes.Ch_1);               /* voltage at probe-1 */
+  if (Phase == 1)                       /* probe-3 via Rl */
+  {
+    Value = ReadU(Probes.Ch_3);         /* voltage at probe-3 */
+    if (U > Value) U -= Value;          /* voltage across cap */
+    else U = 0;
+  }
+
+  /* show phase and voltage */
+  LCD_ClearLine3();                     /* clear line #3 */
+  Display_Char('0' + Phase);
+  Display_Char('/');
+  Display_Char('4');
+  Display_Space();
+  Display_Value(U, -3, 'V');
+
+#ifdef UI_SERIAL_COPY
+  /* serial: time and voltage */
+  Cfg.OP_Control &= ~OP_OUT_LCD;        /* disable display output */
+  Cfg.OP_Control |= OP_OUT_SER;         /* enable serial output */
+  Display_Char('0' + Phase);
+  Display_Space();
+  Display_Value((uint32_t)*Tick * CAP_DA_TICK, -3, 's');
+  Display_Space();
+  Display_Value(U, -3, 'V');
+  Serial_NewLine();                     /* serial: new line */
+  Cfg.OP_Control &= ~OP_OUT_SER;        /* disable serial output */
+  Cfg.OP_Control |= OP_OUT_LCD;         /* enable display output */
+#endif
+
+  return U;
+}
+
+
+/*
+ *  tool for checking dielectric absorption and self-discharge
+ *  of a capacitor
+ *  - uses probe #1 (pos) and probe #3 (neg)
+ *  - phase 1: charge cap via Rl for CAP_DA_SOAK seconds
+ *  - phase 2: disconnect cap for CAP_DA_WAIT seconds
+ *    (self-discharge)
+ *  - phase 3: discharge cap via Rl and short it for CAP_DA_SHORT ticks
+ *  - phase 4: disconnect cap for CAP_DA_WAIT seconds
+ *    (recovery voltage)
+ *  - requires display with more than 3 lines
+ *    (menu item is hidden otherwise)
+ */
+
+void Cap_DA(void)
+{
+  uint8_t           Test;               /* user feedback */
+  uint16_t          Tick;               /* tick counter */
+  uint16_t          n;                  /* counter */
+  uint16_t          U;                  /* voltage */
+  uint16_t          U_Charge = 0;       /* voltage after charging */
+  uint16_t          U_0;                /* voltage at start of phase 2 */
+  uint16_t          U_Max;              /* max. recovery voltage */
+  uint32_t          Value;              /* temp. value */
+  Capacitor_Type    *Cap;               /* pointer to cap data */
+
+  Cap = &Caps[0];                       /* first cap */
+
+  /* show info */
+  LCD_Clear();                          /* clear display */
+#ifdef UI_COLORED_TITLES
+  /* display: cap DA */
+  Display_ColoredEEString(CapDA_str, COLOR_TITLE);
+#else
+  Display_EEString(CapDA_str);          /* display: cap DA */
+#endif
+  Show_SimplePinout('+', 0, '-');       /* probe-1: pos / probe-3: neg */
+
+  while (1)
+  {
+    /*
+     *  short or long key press -> measure
+     *  two short key presses -> exit tool
+     */
+
+    /* wait for user feedback */
+    Test = TestKey(0, CURSOR_BLINK | CHECK_KEY_TWICE | CHECK_BAT);
+
+    if (Test == KEY_TWICE)              /* two short key presses */
+      return;
+
+    /* measure cap */
+    LCD_ClearLine2();                   /* update line #2 */
+    Display_EEString(Probing_str);      /* display: probing... */
+    LCD_ClearLine(3);                   /* clear line #3 */
+    LCD_ClearLine(4);                   /* clear line #4 */
+    Check.Found = COMP_NONE;            /* no component */
+    MeasureCap(PROBE_1, PROBE_3, 0);    /* probe-1 = Vcc, probe-3 = Gnd */
+    LCD_ClearLine2();                   /* update line #2 */
+
+    if (Check.Found != COMP_CAPACITOR)  /* no capacitor */
+    {
+      Display_Minus();
+      continue;
+    }
+
+    /* show capacitance */
+    Display_Value(Cap->Value, Cap->Scale, 'F');
+
+    /*
+     *  set up Timer1:
+     *  - CTC mode (count up to OCR1A)
+     *  - prescaler 1024
+     */
+
+    Tick = 0;
+    U_0 = 0;
+    TCCR1B = 0;                         /* stop timer */
+    TCCR1A = 0;                         /* normal port operation */
+    TCNT1 = 0;                          /* reset counter */
+    OCR1A = CAP_DA_TOP;                 /* tick */
+    TIFR1 = (1 << OCF1A);               /* clear flag */
+    TCCR1B = (1 << WGM12) | (1 << CS12) | (1 << CS10);   /* start timer */
+
+    /*
+     *  phase 1: charge cap
+     *  - probe-3 -- Rl -- Gnd / probe-1 -- Vcc
+     */
+
+    UpdateProbes(PROBE_1, 0, PROBE_3);  /* update register bits and probes */
+    ADC_DDR = 0;                        /* set to HiZ */
+    R_DDR = Probes.Rl_3;                /* select Rl for probe-3 */
+    R_PORT = 0;                         /* pull down probe-3 via Rl */
+    ADC_PORT = Probes.Pin_1;            /* pull up probe-1 directly */
+    ADC_DDR = Probes.Pin_1;             /* enable pull-up of probe-1 */
+
+    n = CAP_DA_SOAK * (1000 / CAP_DA_TICK);
+    while (n > 0)
+    {
+      U_Charge = CapDA_Read(1, &Tick);
+      if (U_Charge == UINT16_MAX) goto stop;
+      n--;
+    }
+
+    /*
+     *  phase 2: self-discharge
+     *  - probe-3 -- Gnd / probe-1 -- HiZ
+     */
+
+    ADC_DDR = 0;                        /* set to HiZ */
+    ADC_PORT = 0;                       /* remove pull-up */
+    R_DDR = 0;                          /* remove Rl */
+    ADC_DDR = Probes.Pin_3;             /* pull down probe-3 directly */
+
+    n = CAP_DA_WAIT * (1000 / CAP_DA_TICK);
+    while (n > 0)
+    {
+      U = CapDA_Read(2, &Tick);
+      if (U == UINT16_MAX) goto stop;
+      if (U_0 == 0) U_0 = U;            /* first sample */
+      n--;
+    }
+
+    /*
+     *  self-discharge time constant: tau = t / ln(U_0 / U)
+     *  - U_0 < 2 U: ln(U_0 / U) ~ 2 (U_0 - U) / (U_0 + U)
+     *  - otherwise: by binary logarithm
+     */
+
+    Value = (uint32_t)(CAP_DA_WAIT * (1000 / CAP_DA_TICK) - 1) * CAP_DA_TICK;
+    if (U == 0) U = 1;                  /* prevent division by zero */
+    if (U_0 <= U) U_0 = U + 1;          /* no drop: show lower limit */
+    if (U_0 < 2 * U)                    /* small drop */
+    {
+      Value *= U_0 + U;
+      Value /= 2 * (U_0 - U);
+    }
+    else                                /* large drop */
+    {
+      Value *= 369;                     /* 256 / ln(2) */
+      Value /= Log2Value(U_0) - Log2Value(U);
+    }
+
+    /* show result */
+    Display_NL_EEString_Space(CapDA_Tau_str);    /* display: tau */
+    Display_Value(Value, -3, 's');      /* display time constant */
+
+    /*
+     *  phase 3: discharge cap
+     *  - probe-3 -- Gnd / probe-1 -- Rl -- Gnd
+     *  - then short cap for CAP_DA_SHORT ticks
+     */
+
+    R_DDR = Probes.Rl_1;                /* pull down probe-1 via Rl */
+
+    n = CAP_DA_SHORT;
+    while (n > 0)
+    {
+      U = CapDA_Read(3, &Tick);
+      if (U == UINT16_MAX) goto stop;
+
+      if (U <= CAP_DISCHARGED)          /* discharged */
+      {
+        ADC_DDR = Probes.Pin_1 | Probes.Pin_3;   /* short cap */
+        n--;
+      }
+    }
+
+    /*
+     *  phase 4: recovery
+     *  - probe-3 -- Gnd / probe-1 -- HiZ
+     */
+
+    ADC_DDR = Probes.Pin_3;             /* pull down probe-3 directly */
+    R_DDR = 0;                          /* remove Rl */
+
+    U_Max = 0;
+    n = CAP_DA_WAIT * (1000 / CAP_DA_TICK);
+    while (n > 0)
+    {
+      U = CapDA_Read(4, &Tick);
+      if (U == UINT16_MAX) goto stop;
+      if (U > U_Max) U_Max = U;         /* new maximum */
+      n--;
+    }
+
+    /* DA = U_max / U_charge (in 0.01%) */
+    Value = U_Max;
+    Value *= 10000;
+    if (U_Charge > 0) Value /= U_Charge;
+
+    /* show result */
+    LCD_ClearLine3();                   /* clear line #3 */
+    Display_EEString_Space(CapDA_DA_str);     /* display: DA */
+    Display_FullValue(Value, 2, '%');   /* display absorption */
+
+stop:
+    TCCR1B = 0;                         /* stop timer */
+    DischargeProbes();                  /* discharge cap */
+
+    /* wait until key is released */
+    while (!(BUTTON_PIN & (1 << TEST_BUTTON)));
+    MilliSleep(50);                     /* time to debounce */
+  }
+}
+
+#endif // SW_CAP_DA
@@ -22,14 +22,54 @@
 
 extern void ESR_Tool(void);
 
+#ifdef SW_ESR_STREAM
+
+#ifndef SW_ESR
+#error <<< ESR streaming requires SW_ESR >>>
+#endif
+
+/* ring buffer: number of slots (power of 2) and loop runs per slot */
+#define ESR_STREAM_SLOTS      8
+#define ESR_STREAM_PULSES     32
+
+/* Timer1 top value for output rate (prescaler 1024) */
+#define ESR_STREAM_TOP        ((F_CPU / 1024) * ESR_STREAM_RATE / 1000 - 1)
+
+#endif // SW_ESR_STREAM
+
 extern const unsigned char ESR_str[];
 
 
 #endif // SW_ESR_TOOL
 
 
+#if defined (SW_CAP_LEAKAGE_LOG) && !defined (SW_CAP_LEAKAGE)
+#error <<< Leakage logging requires SW_CAP_LEAKAGE >>>
+#endif
+
 #ifdef SW_CAP_LEAKAGE
 
+#ifdef SW_CAP_LEAKAGE_LOG
+
+/* ring buffer: number of deltas */
+#define CAP_LOG_SIZE          120
+
+#define FUNC_LOG2VALUE
+#define FUNC_DISPLAY_SIGNEDFULLVALUE
+
+/* leakage log */
+typedef struct
+{
+  uint16_t          First;         /* log code of oldest sample */
+  uint16_t          Last;          /* log code of newest sample */
+  uint16_t          Time;          /* time of newest sample (in s) */
+  uint8_t           Head;          /* slot of oldest delta */
+  uint8_t           Count;         /* number of samples */
+  int8_t            Delta[CAP_LOG_SIZE];    /* deltas between samples */
+} CapLog_Type;
+
+#endif // SW_CAP_LEAKAGE_LOG
+
 extern void Cap_Leakage(void);
 
 extern const unsigned char CapLeak_str[];
@@ -41,4 +81,23 @@ extern const unsigned char CapDischarge_str[];
 #endif // SW_CAP_LEAKAGE
 
 
+#ifdef SW_CAP_DA
+
+/* Timer1 tick in ms and top value (prescaler 1024) */
+#define CAP_DA_TICK           100
+#define CAP_DA_TOP            ((F_CPU / 1024) * CAP_DA_TICK / 1000 - 1)
+
+/* ticks to short cap after discharging */
+#define CAP_DA_SHORT          10
+
+#define FUNC_LOG2VALUE
+#define FUNC_DISPLAY_FULLVALUE
+
+extern void Cap_DA(void);
+
+extern const unsigned char CapDA_str[];
+
+#endif // SW_CAP_DA
+
+
 #endif // CAP_TOOL_H
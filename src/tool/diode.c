@@ -24,6 +24,11 @@
  *  local variabless
  */
 
+#ifdef SW_DIODE_IV
+const unsigned char DiodeIV_n_str[] MEM_TYPE = "n";
+const unsigned char DiodeIV_Rs_str[] MEM_TYPE = "Rs";
+#endif
+
 
 /* ************************************************************************
  *   photodiode check
@@ -281,3 +286,262 @@ void Diode_LED_Check(void)
 }
 
 #endif // SW_DIODE_LED
+
+
+/* ************************************************************************
+ *   diode I-V curve
+ * ************************************************************************ */
+
+#ifdef SW_DIODE_IV
+
+/*
+ *  measure a point of the I-V curve
+ *  - anode (probe-1) via Rl or Rh to Vcc
+ *  - cathode (probe-3) via same resistor or directly to Gnd
+ *  - copies point to serial
+ *
+ *  requires:
+ *  - Mode: drive mode
+ *    DIODE_IV_RL      Rl (otherwise Rh)
+ *    DIODE_IV_DIRECT  cathode directly to Gnd
+ *  - Point: pointer to data of point
+ */
+
+void DiodeIV_Point(uint8_t Mode, DiodeIV_Type *Point)
+{
+  uint8_t           Anode;              /* resistor mask for anode */
+  uint8_t           Cathode;            /* resistor mask for cathode */
+  uint32_t          U_A;                /* voltage at anode (V) */
+  uint32_t          U_C;                /* voltage at cathode (V) */
+
+  /* select resistors */
+  if (Mode & DIODE_IV_RL)          /* Rl */
+  {
+    Anode = Probes.Rl_1;
+    Cathode = Probes.Rl_2;
+  }
+  else                             /* Rh */
+  {
+    Anode = Probes.Rh_1;
+    Cathode = Probes.Rh_2;
+  }
+
+  /* set probes: Gnd -- (R --) cathode / anode -- R -- Vcc */
+  ADC_DDR = 0;                     /* set to HiZ */
+  ADC_PORT = 0;
+  if (Mode & DIODE_IV_DIRECT)      /* cathode directly to Gnd */
+  {
+    ADC_DDR = Probes.Pin_2;        /* pull down cathode directly */
+    Cathode = 0;                   /* no resistor */
+  }
+  R_PORT = Anode;                  /* pull up anode */
+  R_DDR = Anode | Cathode;         /* enable resistors */
+
+  /* get voltages */
+#ifdef ADC_OVERSAMPLING
+  wait5ms();                       /* settle time */
+  U_A = ReadU_uV(Probes.Ch_1, 2);
+  U_C = ReadU_uV(Probes.Ch_2, 2);
+#else
+  U_A = ReadU_5ms(Probes.Ch_1);
+  U_A *= 1000;                     /* mV -> V */
+  U_C = ReadU(Probes.Ch_2);
+  U_C *= 1000;                     /* mV -> V */
+#endif
+
+  /* V_f */
+  if (U_A > U_C) Point->V_f = U_A - U_C;
+  else Point->V_f = 0;
+
+  /* current via anode resistor: I = (Vcc - U_A) / R */
+  U_C = Cfg.Vcc * 1000UL;          /* Vcc in V */
+  if (U_C > U_A) U_C -= U_A;       /* voltage across resistor */
+  else U_C = 0;
+
+  if (Mode & DIODE_IV_RL)          /* Rl */
+  {
+    U_C *= 10;                     /* scale to 0.1 V */
+    U_C /= (R_LOW * 10) + NV.RiH;  /* / 0.1 Ohms -> A */
+    U_C *= 1000;                   /* A -> nA */
+  }
+  else                             /* Rh */
+  {
+    U_C *= 100;                    /* scale to 0.01 V */
+    U_C /= R_HIGH / 10;            /* / 10 Ohms -> nA */
+  }
+  Point->I = U_C;
+
+  /* reset probes */
+  R_DDR = 0;
+  ADC_DDR = 0;
+
+#ifdef UI_SERIAL_COPY
+  /* serial: current and V_f */
+  Cfg.OP_Control &= ~OP_OUT_LCD;        /* disable display output */
+  Cfg.OP_Control |= OP_OUT_SER;         /* enable serial output */
+  Display_Value(Point->I, -9, 'A');
+  Display_Space();
+  Display_Value(Point->V_f, -6, 'V');
+  Serial_NewLine();                     /* serial: new line */
+  Cfg.OP_Control &= ~OP_OUT_SER;        /* disable serial output */
+  Cfg.OP_Control |= OP_OUT_LCD;         /* enable display output */
+#endif
+}
+
+
+/*
+ *  get binary logarithm of current ratio
+ *
+ *  requires:
+ *  - I_1: lower current
+ *  - I_2: higher current (< 16 * I_1)
+ *
+ *  returns:
+ *  - log2(I_2 / I_1) * 256
+ */
+
+uint16_t DiodeIV_Log(uint32_t I_1, uint32_t I_2)
+{
+  uint16_t          Log;
+
+  while (I_2 >= (1UL << 20))       /* prevent overflow */
+  {
+    I_1 >>= 1;                     /* /2 */
+    I_2 >>= 1;                     /* /2 */
+  }
+
+  if (I_1 == 0) return 0;          /* prevent division by zero */
+
+  I_2 <<= 12;                      /* * 4096 */
+  I_2 /= I_1;                      /* ratio * 4096 */
+  if (I_2 > UINT16_MAX) I_2 = UINT16_MAX;
+
+  Log = Log2Value((uint16_t)I_2);
+  if (Log > (12 << 8)) Log -= (12 << 8);     /* / 4096 */
+  else Log = 0;
+
+  return Log;
+}
+
+
+/*
+ *  diode I-V curve
+ *  - uses probes #1 (anode) and #3 (cathode)
+ *  - measures V_f at four currents (about 5A, 10A, 3mA and 7mA)
+ *  - fits the diode equation V_f = n V_T ln(I / I_s) + I R_s
+ *    ideality factor n from the two low currents
+ *    series resistance R_s from the two high currents
+ *  - requires a display with more than 3 text lines
+ *    (menu item is hidden otherwise)
+ */
+
+void Diode_IV(void)
+{
+  uint8_t           Test;               /* user feedback */
+  uint8_t           n;                  /* counter */
+  uint16_t          Log;                /* log2 of current ratio */
+  int32_t           nV_T = 0;           /* n * V_T (V) */
+  int32_t           Value;              /* temp. value */
+  DiodeIV_Type      Point[DIODE_IV_POINTS];   /* I-V points */
+
+  /* show info */
+  LCD_Clear();                          /* clear display */
+#ifdef UI_COLORED_TITLES
+  /* display: diode I-V */
+  Display_ColoredEEString(DiodeIV_str, COLOR_TITLE);
+#else
+  Display_EEString(DiodeIV_str);        /* display: diode I-V */
+#endif
+  Show_SimplePinout('A', 0, 'C');       /* probe-1: anode / probe-3: cathode */
+
+  while (1)
+  {
+    /*
+     *  short or long key press -> measure
+     *  two short key presses -> exit tool
+     */
+
+    /* wait for user feedback */
+    Test = TestKey(0, CURSOR_BLINK | CHECK_KEY_TWICE | CHECK_BAT);
+
+    if (Test == KEY_TWICE)              /* two short key presses */
+      return;
+
+    /* measure curve */
+    LCD_ClearLine2();                   /* update line #2 */
+    Display_EEString(Probing_str);      /* display: probing... */
+    LCD_ClearLine(3);                   /* clear line #3 */
+    LCD_ClearLine(4);                   /* clear line #4 */
+
+    DischargeProbes();                  /* try to discharge probes */
+    UpdateProbes(PROBE_1, PROBE_3, PROBE_2);  /* anode, cathode */
+
+    /* drive modes in order of increasing current */
+    for (n = 0; n < DIODE_IV_POINTS; n++)
+    {
+      wdt_reset();                      /* reset watchdog */
+      DiodeIV_Point(n, &Point[n]);
+    }
+
+    LCD_ClearLine2();                   /* update line #2 */
+
+    /* check for diode: V_f rises with current */
+    if ((Point[0].I == 0) ||
+        (Point[3].V_f < DIODE_IV_MIN_VF) ||
+        (Point[1].V_f <= Point[0].V_f) ||
+        (Point[3].V_f <= Point[2].V_f))
+    {
+      Display_Minus();                  /* no diode */
+      continue;
+    }
+
+    /* show V_f and current of highest point */
+    Display_Value(Point[3].V_f, -6, 'V');
+    Display_Space();
+    Display_Value(Point[3].I, -9, 'A');
+
+    /*
+     *  ideality factor
+     *  - n V_T = (V_f2 - V_f1) / ln(I_2 / I_1)
+     *  - ln(x) = log2(x) * ln(2) = log2(x) * 256 / 369
+     */
+
+    Log = DiodeIV_Log(Point[0].I, Point[1].I);
+    if (Log > 0)
+    {
+      nV_T = Point[1].V_f - Point[0].V_f;
+      nV_T *= 369;
+      nV_T /= Log;
+    }
+
+    Value = nV_T * 100;                 /* scale to 0.01 */
+    Value /= DIODE_IV_V_T;              /* / V_T */
+    Display_NL_EEString_Space(DiodeIV_n_str);     /* display: n */
+    Display_FullValue(Value, 2, 0);
+
+    /*
+     *  series resistance
+     *  - R_s = (V_f4 - V_f3 - n V_T ln(I_4 / I_3)) / (I_4 - I_3)
+     *  - requires a current step of more than 100nA
+     */
+
+    Display_NL_EEString_Space(DiodeIV_Rs_str);    /* display: Rs */
+
+    if (Point[3].I > Point[2].I + 100)  /* sufficient current step */
+    {
+      Log = DiodeIV_Log(Point[2].I, Point[3].I);
+      Value = Point[3].V_f - Point[2].V_f;     /* V */
+      Value -= nV_T * Log / 369;               /* - diode part */
+      if (Value < 0) Value = 0;                /* noise */
+      Value *= 100;
+      Value /= (Point[3].I - Point[2].I) / 100;     /* V / 100nA -> 0.1 Ohms */
+      Display_Value(Value, -1, LCD_CHAR_OMEGA);
+    }
+    else                                /* no current step */
+    {
+      Display_Minus();                  /* display: - */
+    }
+  }
+}
+
+#endif // SW_DIODE_IV
@@ -39,4 +39,38 @@ extern const unsigned char Diode_LED_str[];
 #endif // SW_DIODE_LED
 
 
+#ifdef SW_DIODE_IV
+
+
+/* drive modes for DiodeIV_Point() (bitfield, ordered by current) */
+#define DIODE_IV_DIRECT       0b00000001     /* cathode directly to Gnd */
+#define DIODE_IV_RL           0b00000010     /* Rl (otherwise Rh) */
+
+/* number of points */
+#define DIODE_IV_POINTS       4
+
+/* min. V_f at highest current (V) */
+#define DIODE_IV_MIN_VF       50000
+
+/* thermal voltage V_T at 25C (V) */
+#define DIODE_IV_V_T          25700
+
+#define FUNC_LOG2VALUE
+#define FUNC_DISPLAY_FULLVALUE
+
+/* point of I-V curve */
+typedef struct
+{
+  uint32_t          I;             /* current (nA) */
+  uint32_t          V_f;           /* forward voltage (V) */
+} DiodeIV_Type;
+
+extern void Diode_IV(void);
+
+extern const unsigned char DiodeIV_str[];
+
+
+#endif // SW_DIODE_IV
+
+
 #endif // DIODE_TOOL_H
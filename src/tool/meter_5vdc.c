@@ -159,9 +159,15 @@ void Meter_5VDC(void)
 
     /*
      *  measure voltage
+     *  - with async ADC sampling the display is cleared while
+     *    the samples are taken
      */
 
+#ifdef ADC_ASYNC
+    ADC_Start(Probes.Ch_1);        /* start sampling probe #1 (positive) */
+#else
     U = ReadU(Probes.Ch_1);        /* voltage at probe #1 (postive), in mV */
+#endif
 
     /*
      *  display voltage
@@ -172,6 +178,10 @@ void Meter_5VDC(void)
     for (n = 0; n < 6; n++)        /* clear pos #1 - #6 */
       Display_Space();
 
+#ifdef ADC_ASYNC
+    U = ADC_Collect();             /* voltage at probe #1, in mV */
+#endif
+
     /* display voltage */
     LCD_CharPos(1, 2);             /* pos #1 in line #2 */
     Display_Value(U, -3, 'V');     /* display voltage */
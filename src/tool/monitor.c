@@ -56,6 +56,9 @@ void Monitor_R(void)
   R1 = &Resistors[0];                   /* pointer to first resistor */
   /* increase number of samples to lower spread of measurement values */
   Cfg.Samples = 100;                    /* perform 100 ADC samples */
+#ifdef ADC_ADAPTIVE
+  Cfg.Tolerance = 0;                    /* take all samples */
+#endif
 
   /*
    *  processing loop
@@ -83,6 +86,9 @@ void Monitor_R(void)
 
   /* clean up */
   Cfg.Samples = ADC_SAMPLES;       /* set ADC samples back to default */
+#ifdef ADC_ADAPTIVE
+  Cfg.Tolerance = ADC_TOLERANCE;   /* set tolerance back to default */
+#endif
 }
 
 #endif // SW_MONITOR_R
@@ -302,6 +308,9 @@ void Monitor_RCL(void)
     {
       /* increase number of samples to lower spread of measurement values */
       Cfg.Samples = 100;                /* perform 100 ADC samples */
+#ifdef ADC_ADAPTIVE
+      Cfg.Tolerance = 0;                /* take all samples */
+#endif
 
       /* measure R */
       UpdateProbes2(PROBE_1, PROBE_3);       /* update probes */
@@ -322,6 +331,9 @@ void Monitor_RCL(void)
         Run = 1;                             /* reset to "no component" */
 
       Cfg.Samples = ADC_SAMPLES;        /* set ADC samples back to default */
+#ifdef ADC_ADAPTIVE
+      Cfg.Tolerance = ADC_TOLERANCE;    /* set tolerance back to default */
+#endif
     }
 
     if (Run != COMP_INDUCTOR)           /* none, C or R */
@@ -410,6 +422,9 @@ void Monitor_RL(void)
   R1 = &Resistors[0];                   /* pointer to first resistor */
   /* increase number of samples to lower spread of measurement values */
   Cfg.Samples = 100;                    /* perform 100 ADC samples */
+#ifdef ADC_ADAPTIVE
+  Cfg.Tolerance = 0;                    /* take all samples */
+#endif
 
   /*
    *  processing loop
@@ -447,6 +462,9 @@ void Monitor_RL(void)
 
   /* clean up */
   Cfg.Samples = ADC_SAMPLES;       /* set ADC samples back to default */
+#ifdef ADC_ADAPTIVE
+  Cfg.Tolerance = ADC_TOLERANCE;   /* set tolerance back to default */
+#endif
 }
 
 #endif // SW_MONITOR_RL
@@ -223,12 +223,18 @@ void OptoCoupler_Tool(void)
 
         /* get voltages at current shunts */
         Cfg.Samples = 10;               /* just a few samples for 1ms runtime */
+#ifdef ADC_ADAPTIVE
+        Cfg.Tolerance = 0;              /* take all samples */
+#endif
         R_PORT = Probes.Rl_1;           /* turn LED on */
         wait1ms();                      /* time for propagation delay */
         U1 = ReadU(Probes.Ch_1);        /* voltage at LED's anode (Rl) */
         U2 = ReadU(Probes.Ch_2);        /* voltage at emitter (RiL) */
         R_PORT = 0;                     /* turn LED off */
         Cfg.Samples = ADC_SAMPLES;      /* reset samples to default */
+#ifdef ADC_ADAPTIVE
+        Cfg.Tolerance = ADC_TOLERANCE;  /* reset tolerance to default */
+#endif
 
         /* calculate LED's If */
         /* If = (Vcc - U1) / (RiH + Rl) */
@@ -221,6 +221,49 @@ int8_t NormalizeValue(uint32_t Value1, int8_t Scale1, uint32_t Value2, int8_t Sc
 #endif // SW_R_TRIMMER
 
 
+#ifdef FUNC_LOG2VALUE
+
+/*
+ *  get binary logarithm of a value
+ *  - fixed point with 8 fractional bits
+ *  - fraction is approximated by f + c*f*(1-f) with c = 0.3466
+ *    (error < 0.01)
+ *
+ *  requires:
+ *  - Value: value (> 0)
+ *
+ *  returns:
+ *  - log2(Value) * 256
+ *  - 0 for Value = 0
+ */
+
+uint16_t Log2Value(uint16_t Value)
+{
+  uint16_t          Log;           /* return value */
+  uint32_t          Frac;          /* fractional part */
+
+  if (Value == 0) return 0;        /* prevent endless loop */
+
+  /* integer part: position of MSB */
+  Log = 15 << 8;
+  while (! (Value & 0x8000))       /* shift MSB to bit 15 */
+  {
+    Value <<= 1;
+    Log -= 1 << 8;
+  }
+
+  /* fractional part: bits below MSB */
+  Frac = Value & 0x7FFF;           /* remove MSB */
+  Frac <<= 1;                      /* f (16 bits) */
+  Frac += ((Frac * (65536 - Frac) >> 16) * 22713) >> 16;   /* c*f*(1-f) */
+  Log += (Frac + 128) >> 8;        /* round to 8 bits */
+
+  return Log;
+}
+
+#endif // FUNC_LOG2VALUE
+
+
 #ifdef FUNC_ROUNDSIGNEDVALUE
 
 /*
@@ -1392,7 +1435,7 @@ uint8_t MenuTool(uint8_t Items, uint8_t Type, void *Menu[], unsigned char *Unit)
         LCD_ClearLine(0);     /* clear rest of this line */
       }
 
-      Address += 2;                /* next address (2 byte steps) */
+      Address += sizeof(Menu[0]);  /* next address (pointer size) */
       n++;                         /* next item */
 
       if (n > Items)
@@ -1686,6 +1729,9 @@ void AdjustmentMenu(uint8_t Mode)
 #define MENUITEM_DIODE_LED        41
 #define MENUITEM_METER_5VDC       42
 #define MENUITEM_INA226           43
+#define MENUITEM_CAP_DA           44
+#define MENUITEM_DIODE_IV         45
+#define MENUITEM_LAST_RESET       46
 
 
 /*
@@ -1937,14 +1983,33 @@ uint8_t PresentMainMenu(void)
   #define ITEM_39      0
 #endif
 
+#ifdef SW_CAP_DA
+  #define ITEM_40      1
+#else
+  #define ITEM_40      0
+#endif
+
+#ifdef SW_DIODE_IV
+  #define ITEM_41      1
+#else
+  #define ITEM_41      0
+#endif
+
+#ifdef SW_SAME_AS_LAST
+  #define ITEM_42      1
+#else
+  #define ITEM_42      0
+#endif
+
 
 #define ITEMS_PACK_0   (ITEM_01 + ITEM_02 + ITEM_03 + ITEM_04 + ITEM_05 + ITEM_06 + ITEM_07 + ITEM_08 + ITEM_09 + ITEM_10)
 #define ITEMS_PACK_1   (ITEM_11 + ITEM_12 + ITEM_13 + ITEM_14 + ITEM_15 + ITEM_16 + ITEM_17 + ITEM_18 + ITEM_19 + ITEM_20)
 #define ITEMS_PACK_2   (ITEM_21 + ITEM_22 + ITEM_23 + ITEM_24 + ITEM_25 + ITEM_26 + ITEM_27 + ITEM_28 + ITEM_29 + ITEM_30)
-#define ITEMS_PACK_3   (ITEM_31 + ITEM_32 + ITEM_33 + ITEM_34 + ITEM_35 + ITEM_36 + ITEM_37 + ITEM_38 + ITEM_39)
+#define ITEMS_PACK_3   (ITEM_31 + ITEM_32 + ITEM_33 + ITEM_34 + ITEM_35 + ITEM_36 + ITEM_37 + ITEM_38 + ITEM_39 + ITEM_40)
+#define ITEMS_PACK_4   (ITEM_41 + ITEM_42)
 
 /* number of menu items */
-#define MENU_ITEMS     (ITEMS_BASIC + ITEMS_PACK_0 + ITEMS_PACK_1 + ITEMS_PACK_2 + ITEMS_PACK_3)
+#define MENU_ITEMS     (ITEMS_BASIC + ITEMS_PACK_0 + ITEMS_PACK_1 + ITEMS_PACK_2 + ITEMS_PACK_3 + ITEMS_PACK_4)
 
   /*
    *  local variables
@@ -2013,6 +2078,16 @@ uint8_t PresentMainMenu(void)
   n++;
 #endif
 
+#ifdef SW_CAP_DA
+  /* cap DA (requires 4 lines) */
+  if (UI.CharMax_Y >= 4)
+  {
+    Item_Str[n] = (void *)CapDA_str;
+    Item_ID[n] = MENUITEM_CAP_DA;
+    n++;
+  }
+#endif
+
 #ifdef SW_MONITOR_R
   /* monitor R */
   Item_Str[n] = (void *)Monitor_R_str;
@@ -2118,6 +2193,16 @@ uint8_t PresentMainMenu(void)
   n++;
 #endif
 
+#ifdef SW_DIODE_IV
+  /* diode I-V curve (requires 4 lines) */
+  if (UI.CharMax_Y >= 4)
+  {
+    Item_Str[n] = (void *)DiodeIV_str;
+    Item_ID[n] = MENUITEM_DIODE_IV;
+    n++;
+  }
+#endif
+
 #ifdef SW_SERVO
   /* servo check */
   Item_Str[n] = (void *)Servo_str;
@@ -2240,6 +2325,13 @@ uint8_t PresentMainMenu(void)
   Item_ID[n] = MENUITEM_SHOW;
   n++;
 
+#ifdef SW_SAME_AS_LAST
+  /* reset reference of same-as-last mode */
+  Item_Str[n] = (void *)Last_Reset_str;
+  Item_ID[n] = MENUITEM_LAST_RESET;
+  n++;
+#endif
+
 #ifdef SW_FONT_TEST
   /* font test */
   Item_Str[n] = (void *)FontTest_str;
@@ -2288,6 +2380,7 @@ uint8_t PresentMainMenu(void)
   #undef ITEMS_PACK_1
   #undef ITEMS_PACK_2
   #undef ITEMS_PACK_3
+  #undef ITEMS_PACK_4
 
   #undef ITEM_01
   #undef ITEM_02
@@ -2328,6 +2421,9 @@ uint8_t PresentMainMenu(void)
   #undef ITEM_37
   #undef ITEM_38
   #undef ITEM_39
+  #undef ITEM_40
+  #undef ITEM_41
+  #undef ITEM_42
 
   return(ID);                 /* return item ID */
 }
@@ -2517,6 +2613,13 @@ uint8_t MainMenu(void)
       break;
 #endif
 
+#ifdef SW_CAP_DA
+    /* cap DA */
+    case MENUITEM_CAP_DA:
+      Cap_DA();
+      break;
+#endif
+
 #ifdef SW_POWER_OFF
     /* power off */
     case MENUITEM_POWER_OFF:
@@ -2671,6 +2774,20 @@ uint8_t MainMenu(void)
       break;
 #endif
 
+#ifdef SW_DIODE_IV
+    /* diode I-V curve */
+    case MENUITEM_DIODE_IV:
+      Diode_IV();
+      break;
+#endif
+
+#ifdef SW_SAME_AS_LAST
+    /* reset reference of same-as-last mode */
+    case MENUITEM_LAST_RESET:
+      Last_Reset();
+      break;
+#endif
+
 #ifdef SW_METER_5VDC
     /* Voltmeter 0-5V DC */
     case MENUITEM_METER_5VDC:
@@ -144,6 +144,11 @@ extern int8_t NormalizeValue(uint32_t Value1, int8_t Scale1, uint32_t Value2, in
 #endif // SW_R_TRIMMER
 
 
+#ifdef FUNC_LOG2VALUE
+extern uint16_t Log2Value(uint16_t Value);
+#endif
+
+
 #ifdef FUNC_ROUNDSIGNEDVALUE
 extern int32_t RoundSignedValue(int32_t Value, uint8_t Scale, uint8_t RoundScale);
 #endif
@@ -44,4 +44,53 @@ extern void wait2us(void);
 extern void wait1us(void);
 
 
+#if defined (SW_PROFILER) || defined (ADC_STATE_CACHE)
+
+/*
+ *  wrapper for wait functions
+ *  - macro name and function name are the same, the function called
+ *    in the macro's expansion isn't expanded again
+ *  - only the ms-range waits are wrapped, the overhead would distort
+ *    the timing of the s-range waits (e.g. ESR pulses)
+ *  - SW_PROFILER: accounts wait time
+ *  - ADC_STATE_CACHE: the ADC has been idle for 1ms at least,
+ *    so the next reading needs a dummy conversion again
+ */
+
+#ifdef SW_PROFILER
+  #define WAIT_PROF_START()   Prof_WaitStart()
+  #define WAIT_PROF_STOP()    Prof_WaitStop()
+#else
+  #define WAIT_PROF_START()   ((void)0)
+  #define WAIT_PROF_STOP()    ((void)0)
+#endif
+
+#ifdef ADC_STATE_CACHE
+  #define WAIT_ADC_IDLE()     (ADC_State.Flags &= ~ADC_STATE_VALID)
+#else
+  #define WAIT_ADC_IDLE()     ((void)0)
+#endif
+
+#define WAIT_WRAP(Function)   (WAIT_PROF_START(), Function(), WAIT_PROF_STOP(), WAIT_ADC_IDLE())
+
+#define wait1s()              WAIT_WRAP(wait1s)
+#define wait500ms()           WAIT_WRAP(wait500ms)
+#define wait400ms()           WAIT_WRAP(wait400ms)
+#define wait300ms()           WAIT_WRAP(wait300ms)
+#define wait200ms()           WAIT_WRAP(wait200ms)
+#define wait100ms()           WAIT_WRAP(wait100ms)
+#define wait50ms()            WAIT_WRAP(wait50ms)
+#define wait40ms()            WAIT_WRAP(wait40ms)
+#define wait30ms()            WAIT_WRAP(wait30ms)
+#define wait20ms()            WAIT_WRAP(wait20ms)
+#define wait10ms()            WAIT_WRAP(wait10ms)
+#define wait5ms()             WAIT_WRAP(wait5ms)
+#define wait4ms()             WAIT_WRAP(wait4ms)
+#define wait3ms()             WAIT_WRAP(wait3ms)
+#define wait2ms()             WAIT_WRAP(wait2ms)
+#define wait1ms()             WAIT_WRAP(wait1ms)
+
+#endif // SW_PROFILER || ADC_STATE_CACHE
+
+
 #endif // WAIT_H